@@ -0,0 +1,69 @@
+//
+//  DAG_bench_acyclic.cpp
+//
+//  Insert throughput of DynamicTopologicalOrder compared with checking for a cycle
+//  with a full traversal before every insert.
+//
+//  usage: DAG_bench_acyclic [nodes] [links]
+//
+
+#include "dag/DynamicTopologicalOrder.h"
+#include <chrono>
+#include <random>
+
+typedef DAG::Node<int> INode;
+
+// random links, mostly going "forward" (as in a decay history) with some going backwards
+std::vector<std::pair<int, int>> makeLinks(int nodes, int links) {
+  std::mt19937 random(1);
+  std::vector<std::pair<int, int>> result;
+  for (int i = 0; i < links; ++i) {
+    int a = random() % nodes;
+    int b = random() % nodes;
+    if (random() % 10 != 0 && a > b) std::swap(a, b);
+    result.emplace_back(a, b);
+  }
+  return result;
+}
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  int nodes = argc > 1 ? std::atoi(argv[1]) : 20000;
+  int links = argc > 2 ? std::atoi(argv[2]) : 2 * nodes;
+  auto pairs = makeLinks(nodes, links);
+
+  // DynamicTopologicalOrder
+  std::vector<INode> graph(nodes);
+  DAG::DynamicTopologicalOrder<INode> dag;
+  for (auto& n : graph)
+    dag.addNode(n);
+  int accepted = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& link : pairs)
+    accepted += dag.addChild(graph[link.first], graph[link.second]);
+  double dynamic = seconds(start);
+  std::cout << "DynamicTopologicalOrder: " << links << " inserts, " << accepted << " accepted in " << dynamic
+            << " s (" << links / dynamic << " inserts/s)" << std::endl;
+
+  // full check: search the descendants of the child for the parent before every insert
+  std::vector<INode> plain(nodes);
+  DAG::BFSVisitor<INode> bfs;
+  int plainAccepted = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < links; ++i) {
+    INode& parent = plain[pairs[i].first];
+    INode& child = plain[pairs[i].second];
+    if (&parent == &child) continue;
+    auto descendants = bfs.traverseChildren(child);
+    if (std::find(descendants.begin(), descendants.end(), &parent) != descendants.end()) continue;
+    parent.addChild(child);
+    ++plainAccepted;
+  }
+  double full = seconds(start);
+  std::cout << "Full traversal check: " << links << " inserts, " << plainAccepted << " accepted in " << full
+            << " s (" << links / full << " inserts/s)" << std::endl;
+  return 0;
+}
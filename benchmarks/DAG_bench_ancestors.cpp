@@ -0,0 +1,78 @@
+//
+//  DAG_bench_ancestors.cpp
+//
+//  Batched minimal common ancestor queries with CommonAncestorIndex on decay histories of growing size,
+//  compared with the searches of CommonAncestors. The query cost of the index should stay nearly flat as the
+//  graph grows while the searches grow with the depth of the history.
+//
+//  usage: DAG_bench_ancestors [largest size] [1 in how many nodes has a second parent] [queries]
+//
+
+#include "dag/CommonAncestors.h"
+#include <chrono>
+#include <random>
+
+typedef DAG::Node<int> INode;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  int largest = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int merges = argc > 2 ? std::atoi(argv[2]) : 20;
+  int queries = argc > 3 ? std::atoi(argv[3]) : 100000;
+
+  for (int nodes = 10000; nodes <= largest; nodes *= 10) {
+    // each node decays from a node created shortly before it, a few also merge with a sibling of that node
+    std::mt19937 random(1);
+    std::vector<INode> graph(nodes);
+    std::vector<int> decayedFrom(nodes, -1);
+    std::vector<int> lastDecay(nodes, -1);  // the latest node that decayed from each node
+    for (int i = 1; i < nodes; ++i) {
+      int parent = std::max(0, i - 1 - int(random() % 50));
+      graph[parent].addChild(graph[i]);
+      if (random() % merges == 0 && decayedFrom[parent] >= 0 && lastDecay[decayedFrom[parent]] != parent)
+        graph[lastDecay[decayedFrom[parent]]].addChild(graph[i]);
+      decayedFrom[i] = parent;
+      lastDecay[parent] = i;
+    }
+    DAG::Nodevector<INode> all;
+    for (auto& n : graph)
+      all.push_back(&n);
+    DAG::CompactGraph<INode> compact(all);
+
+    auto start = std::chrono::steady_clock::now();
+    DAG::CommonAncestorIndex<INode> index;
+    index.build(compact);
+    std::cout << nodes << " nodes: index built in " << seconds(start) << " s, " << index.memory() / 1024.0 / 1024.0
+              << " MB" << std::endl;
+
+    // pairs of nodes anywhere in the history
+    std::vector<std::vector<unsigned>> batch;
+    for (int i = 0; i < queries; ++i)
+      batch.push_back({unsigned(random() % nodes), unsigned(random() % nodes)});
+    start = std::chrono::steady_clock::now();
+    auto results = index.minimalBatch(batch);  // on one thread, to compare with the searches
+    double elapsed = seconds(start);
+    std::cout << "  CommonAncestorIndex: " << queries << " queries (" << index.searches() << " searches) in "
+              << elapsed << " s (" << 1e6 * elapsed / queries << " us/query)" << std::endl;
+
+    DAG::CommonAncestors<INode> ancestors;
+    int searches = std::min(queries, 20);
+    std::size_t same = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < searches; ++i) {
+      std::vector<unsigned> found;
+      for (auto node : ancestors.minimal({compact.node(batch[i][0]), compact.node(batch[i][1])}))
+        found.push_back(compact.index(node));
+      std::sort(found.begin(), found.end());
+      std::sort(results[i].begin(), results[i].end());
+      same += found == results[i];
+    }
+    elapsed = seconds(start);
+    std::cout << "  CommonAncestors: " << searches << " queries (" << same << " agree) in " << elapsed << " s ("
+              << 1e6 * elapsed / searches << " us/query)" << std::endl;
+  }
+  return 0;
+}
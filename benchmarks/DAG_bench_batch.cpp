@@ -0,0 +1,61 @@
+//
+//  DAG_bench_batch.cpp
+//
+//  Throughput of finding the blocks of many small independent event graphs: one FloodFill::traverse per
+//  event compared with EventBatch (reused per worker scratch) for increasing numbers of threads.
+//
+//  usage: DAG_bench_batch [events] [nodes per event] [max threads]
+//
+
+#include "dag/EventBatch.h"
+#include <chrono>
+#include <numeric>
+#include <random>
+
+typedef DAG::Node<int> INode;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  int eventCount = argc > 1 ? std::atoi(argv[1]) : 20000;
+  int nodes = argc > 2 ? std::atoi(argv[2]) : 200;
+  unsigned maxThreads = argc > 3 ? std::atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+
+  // sparse random links between nearby nodes give a few dozen blocks per event
+  std::mt19937 random(1);
+  std::vector<std::vector<INode>> events(eventCount);
+  for (auto& event : events) {
+    event.reserve(nodes);
+    for (int i = 0; i < nodes; ++i)
+      event.emplace_back(i);
+    for (int i = 1; i < nodes; ++i)
+      if (random() % 4 != 0) event[std::max(0, i - 1 - int(random() % 8))].addChild(event[i]);
+  }
+
+  DAG::FloodFill<int> fill;
+  auto start = std::chrono::steady_clock::now();
+  std::size_t blocks = 0;
+  for (auto& event : events)
+    blocks += fill.traverse(event).size();
+  double elapsed = seconds(start);
+  std::cout << "FloodFill::traverse: " << blocks << " blocks in " << elapsed << " s (" << eventCount / elapsed
+            << " events/s)" << std::endl;
+
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    DAG::ThreadPool pool(threads);
+    DAG::EventBatch<int> batch(&pool);
+    std::vector<std::size_t> found(events.size());
+    auto count = [&found](std::size_t event, const DAG::FloodFill<int>::Blocks& blocks, unsigned) {
+      found[event] = blocks.size();
+    };
+    batch.process(events, count);  // warm up: grow the scratch buffers
+    start = std::chrono::steady_clock::now();
+    batch.process(events, count);
+    elapsed = seconds(start);
+    std::cout << "EventBatch, " << threads << " threads: " << std::accumulate(found.begin(), found.end(), 0ul)
+              << " blocks in " << elapsed << " s (" << eventCount / elapsed << " events/s)" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+//
+//  DAG_bench_payload.cpp
+//
+//  Cost of large payloads for traversal-only work: summing one field over the descendants of many start
+//  nodes with BFSVisitor on the Nodes (payload next to the links), with CompactBFS reading the field from the
+//  Nodes (same search, so the difference to the next run is the payload alone) and with CompactBFS plus a
+//  NodeColumn (topology and the field in arrays of their own).
+//
+//  usage: DAG_bench_payload [nodes] [traversals]
+//
+
+#include "dag/CompactBFS.h"
+#include <chrono>
+#include <random>
+
+struct Payload {
+  double energy;
+  char detail[504];  // eg track states or cluster shapes that the traversal does not need
+};
+typedef DAG::Node<Payload> PNode;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int traversals = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+  std::mt19937 random(1);
+  std::vector<PNode> nodes;
+  nodes.reserve(count);
+  for (int i = 0; i < count; ++i)
+    nodes.emplace_back(Payload{double(i % 10), {}});
+  for (int i = 1; i < count; ++i)
+    nodes[std::max(0, i - 1 - int(random() % 200))].addChild(nodes[i]);
+  DAG::Nodevector<PNode> all;
+  for (auto& node : nodes)
+    all.push_back(&node);
+  std::vector<int> starts;
+  for (int i = 0; i < traversals; ++i)
+    starts.push_back(random() % std::max(1, count / 2));
+
+  DAG::BFSVisitor<PNode> bfs;
+  bfs.setReuseBuffers(true);
+  auto start = std::chrono::steady_clock::now();
+  double sum = 0;
+  std::size_t visited = 0;
+  for (int s : starts)
+    for (auto node : bfs.traverseChildren(nodes[s], 6)) {
+      sum += node->value().energy;
+      ++visited;
+    }
+  double elapsed = seconds(start);
+  std::cout << "BFSVisitor on Nodes: " << visited << " nodes visited, sum " << sum << ", " << elapsed << " s ("
+            << visited / elapsed << " nodes/s)" << std::endl;
+
+  DAG::CompactGraph<PNode> graph(all);
+  DAG::NodeColumn<double> energy(graph, [](const PNode* node) { return node->value().energy; });
+  DAG::CompactBFS<PNode> compact(graph);
+  start = std::chrono::steady_clock::now();
+  sum = 0;
+  visited = 0;
+  for (int s : starts)
+    for (auto i : compact.traverse(graph.index(&nodes[s]), DAG::VisitType::CHILDREN, 6)) {
+      sum += graph.node(i)->value().energy;
+      ++visited;
+    }
+  elapsed = seconds(start);
+  std::cout << "CompactBFS + Node payload: " << visited << " nodes visited, sum " << sum << ", " << elapsed
+            << " s (" << visited / elapsed << " nodes/s)" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  sum = 0;
+  visited = 0;
+  for (int s : starts)
+    for (auto i : compact.traverse(graph.index(&nodes[s]), DAG::VisitType::CHILDREN, 6)) {
+      sum += energy[i];
+      ++visited;
+    }
+  elapsed = seconds(start);
+  std::cout << "CompactBFS + NodeColumn: " << visited << " nodes visited, sum " << sum << ", " << elapsed
+            << " s (" << visited / elapsed << " nodes/s)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,65 @@
+//
+//  DAG_bench_prefetch.cpp
+//
+//  Effect of the prefetch distance on searches of graphs that do not fit in the cache: undirected searches of
+//  a randomly linked graph (every node is reached) with BFSVisitor on the Nodes and CompactBFS on a
+//  CompactGraph, for several distances (0 = no prefetching).
+//
+//  usage: DAG_bench_prefetch [nodes] [repeats]
+//
+
+#include "dag/CompactBFS.h"
+#include <chrono>
+#include <random>
+
+typedef DAG::Node<int> INode;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  // a random tree plus as many random links again
+  std::mt19937 random(1);
+  std::vector<INode> nodes;
+  nodes.reserve(count);
+  for (int i = 0; i < count; ++i)
+    nodes.emplace_back(i);
+  for (int i = 1; i < count; ++i)
+    nodes[random() % i].addChild(nodes[i]);
+  for (int i = 0; i < count; ++i) {
+    int a = random() % count, b = random() % count;
+    if (a < b) nodes[a].addChild(nodes[b]);
+  }
+  DAG::Nodevector<INode> all;
+  for (auto& node : nodes)
+    all.push_back(&node);
+  std::shuffle(all.begin(), all.end(), random);
+  DAG::CompactGraph<INode> graph(all);
+
+  DAG::BFSVisitor<INode> bfs;
+  bfs.setReuseBuffers(true);
+  DAG::CompactBFS<INode> compact(graph);
+  // the distances take turns so that a slow patch of the machine does not favour one of them
+  std::vector<unsigned> distances{0, 1, 2, 4, 8, 16, 32, 64};
+  std::vector<double> nodeTime(distances.size(), 0.), compactTime(distances.size(), 0.);
+  std::size_t visited = 0;
+  for (int r = 0; r < repeats; ++r)
+    for (std::size_t d = 0; d < distances.size(); ++d) {
+      bfs.setPrefetchDistance(distances[d]);
+      compact.setPrefetchDistance(distances[d]);
+      auto start = std::chrono::steady_clock::now();
+      visited = bfs.traverseUndirected(nodes[r]).size();
+      nodeTime[d] += seconds(start);
+      start = std::chrono::steady_clock::now();
+      visited = compact.traverse(graph.index(&nodes[r]), DAG::VisitType::UNDIRECTED).size();
+      compactTime[d] += seconds(start);
+    }
+  for (std::size_t d = 0; d < distances.size(); ++d)
+    std::cout << "distance " << distances[d] << ": BFSVisitor " << nodeTime[d] / repeats << " s, CompactBFS "
+              << compactTime[d] / repeats << " s per search (" << visited << " nodes)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,72 @@
+//
+//  DAG_bench_reachability.cpp
+//
+//  Build time, memory and query throughput of ReachabilityIndex on a large random DAG,
+//  compared with answering each query with a traversal.
+//
+//  usage: DAG_bench_reachability [nodes] [links per node] [queries]
+//
+
+#include "dag/ReachabilityIndex.h"
+#include <chrono>
+#include <random>
+
+typedef DAG::Node<int> INode;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  int nodes = argc > 1 ? std::atoi(argv[1]) : 200000;
+  int links = argc > 2 ? std::atoi(argv[2]) : 3;
+  int queries = argc > 3 ? std::atoi(argv[3]) : 1000000;
+
+  // each node gets parents among the nodes created shortly before it (like a decay history)
+  std::mt19937 random(1);
+  std::vector<INode> graph(nodes);
+  for (int i = 1; i < nodes; ++i)
+    for (int k = 0; k < links; ++k)
+      graph[std::max(0, i - 1 - int(random() % 1000))].addChild(graph[i]);
+  DAG::Nodevector<INode> all;
+  for (auto& n : graph)
+    all.push_back(&n);
+
+  auto start = std::chrono::steady_clock::now();
+  DAG::CompactGraph<INode> compact(all);
+  std::cout << "CompactGraph: " << compact.size() << " nodes, " << compact.edges() << " links, built in "
+            << seconds(start) << " s" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  DAG::ReachabilityIndex<INode> index;
+  index.build(compact);
+  std::cout << "ReachabilityIndex: built in " << seconds(start) << " s, " << index.memory() / 1024.0 / 1024.0
+            << " MB" << std::endl;
+
+  std::vector<std::pair<unsigned, unsigned>> pairs;
+  for (int i = 0; i < queries; ++i) {
+    unsigned a = random() % nodes;
+    pairs.emplace_back(a, std::min<unsigned>(nodes - 1, a + random() % 5000));  // mostly nearby nodes
+  }
+  start = std::chrono::steady_clock::now();
+  std::size_t positive = 0;
+  for (auto& pair : pairs)
+    positive += index.reaches(pair.first, pair.second);
+  double elapsed = seconds(start);
+  std::cout << "ReachabilityIndex: " << queries << " queries (" << positive << " true, " << index.fallbacks()
+            << " fallback searches) in " << elapsed << " s (" << queries / elapsed << " queries/s)" << std::endl;
+
+  // the same queries answered by traversing the parents of the second node
+  DAG::BFSVisitor<INode> bfs;
+  int traversals = std::min(queries, 200);
+  start = std::chrono::steady_clock::now();
+  std::size_t traversalPositive = 0;
+  for (int i = 0; i < traversals; ++i) {
+    auto ancestors = bfs.traverseParents(graph[pairs[i].second]);
+    traversalPositive += std::find(ancestors.begin(), ancestors.end(), &graph[pairs[i].first]) != ancestors.end();
+  }
+  elapsed = seconds(start);
+  std::cout << "traverseParents: " << traversals << " queries (" << traversalPositive << " true) in " << elapsed
+            << " s (" << traversals / elapsed << " queries/s)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,77 @@
+//
+//  DAG_bench_reorder.cpp
+//
+//  Effect of the node numbering on searches of a CompactGraph. The nodes come in a random order (as ids taken
+//  from an event store would) and are renumbered with each Reordering, then the same CompactBFS searches
+//  (summing a NodeColumn) and a FloodFill of the whole graph are timed.
+//
+//  usage: DAG_bench_reorder [nodes] [traversals]
+//
+
+#include "dag/CompactBFS.h"
+#include "dag/FloodFill.h"
+#include "dag/Reordering.h"
+#include <chrono>
+#include <random>
+
+typedef DAG::Node<int> INode;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int traversals = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+  // blocks of 2000 nodes, each node a child of one of the 50 nodes made before it in its block
+  std::mt19937 random(1);
+  std::vector<INode> nodes;
+  nodes.reserve(count);
+  for (int i = 0; i < count; ++i)
+    nodes.emplace_back(i);
+  for (int i = 0; i < count; ++i)
+    if (i % 2000) nodes[std::max(i - i % 2000, i - 1 - int(random() % 50))].addChild(nodes[i]);
+  DAG::Nodevector<INode> all;
+  for (auto& node : nodes)
+    all.push_back(&node);
+  std::shuffle(all.begin(), all.end(), random);
+  std::vector<const INode*> starts;
+  for (int i = 0; i < traversals; ++i)
+    starts.push_back(&nodes[random() % count]);
+
+  const char* names[] = {"random", "BFS", "RCM", "HUBS"};
+  for (int run = 0; run < 4; ++run) {
+    DAG::CompactGraph<INode> graph(all);
+    DAG::NodeColumn<double> value(graph, [](const INode* node) { return 0.5 * node->value(); });
+    auto start = std::chrono::steady_clock::now();
+    if (run > 0) {
+      DAG::Reordering<INode> reordering;
+      const auto& order = reordering.compute(graph, DAG::Ordering(run - 1));
+      graph.permute(order);
+      value.permute(order);
+    }
+    double reorder = seconds(start);
+
+    DAG::CompactBFS<INode> bfs(graph);
+    start = std::chrono::steady_clock::now();
+    double sum = 0;
+    std::size_t visited = 0;
+    for (auto node : starts)
+      for (auto i : bfs.traverse(graph.index(node), DAG::VisitType::UNDIRECTED)) {
+        sum += value[i];
+        ++visited;
+      }
+    double search = seconds(start);
+
+    DAG::FloodFill<int> ffill;
+    start = std::chrono::steady_clock::now();
+    std::size_t blocks = ffill.traverse(graph).size();
+    double fill = seconds(start);
+
+    std::cout << names[run] << ": reordering " << reorder << " s, CompactBFS " << search << " s (" << visited
+              << " nodes, sum " << sum << ", " << visited / search << " nodes/s), FloodFill " << fill << " s ("
+              << blocks << " blocks)" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+#ifndef DAG_BIDIRECTIONALSEARCH_H
+#define DAG_BIDIRECTIONALSEARCH_H
+/** @class   DAG::BidirectionalSearch
+ *
+ *  @brief BidirectionalSearch finds a shortest path (fewest links) between two nodes
+ *
+ *   Two breadth first searches are run, one from each end, and the one with the smaller frontier is expanded
+ *   by a level at each step until they meet. Each search only has to go about half the distance, so on large
+ *   graphs far fewer nodes are visited than with a single search from one of the nodes.
+ *
+ *   With CHILDREN the path follows child links from the first node to the second, with PARENTS it follows
+ *   parent links and with UNDIRECTED it may use either.
+ *
+ *  Example usage:
+ *
+ DAG::BidirectionalSearch<INode> search;
+ for (auto node : search.shortestPath(n0, n8))
+   std::cout << node->value() << std::endl;
+ *
+ */
+
+#include "DirectedAcyclicGraph.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace DAG {
+/// BidirectionalSearch finds shortest unweighted paths by searching from both ends
+template <typename N>  /// N is the Node
+class BidirectionalSearch {
+public:
+  BidirectionalSearch();
+  /**
+   the shortest path between two nodes
+   @param const N& from - first node of the path
+   @param const N& to - last node of the path
+   @param VisitType visittype - CHILDREN/PARENTS/UNDIRECTED
+   @param int depth - the longest path (in links) that is looked for (-1 = no limit)
+   @return const Nodevector<N>& - the path from "from" to "to", empty if there is none
+   */
+  const Nodevector<N>& shortestPath(const N& from, const N& to, VisitType visittype = VisitType::UNDIRECTED,
+                                    int depth = -1);
+  /// number of nodes reached by the last search
+  std::size_t visited() const { return m_reached[0].size() + m_reached[1].size(); }
+
+private:
+  struct Reached {
+    const N* previous;  ///< the node it was reached from (nullptr for the start)
+    int depth;          ///< distance from the start of that search
+  };
+  std::unordered_map<const N*, Reached> m_reached[2];  ///< nodes reached by the forward and backward searches
+  Nodevector<N> m_frontier[2];
+  Nodevector<N> m_next;
+  Nodevector<N> m_path;
+
+  template <typename F>
+  void forEachLink(const N* node, bool children, bool parents, F f) const;
+};
+
+/// Constructor
+template <typename N>
+BidirectionalSearch<N>::BidirectionalSearch() {}
+
+template <typename N>
+template <typename F>
+void BidirectionalSearch<N>::forEachLink(const N* node, bool children, bool parents, F f) const {
+  if (children)
+    for (auto next : node->children())
+      f(next);
+  if (parents)
+    for (auto next : node->parents())
+      f(next);
+}
+
+template <typename N>
+const Nodevector<N>& BidirectionalSearch<N>::shortestPath(const N& from, const N& to, VisitType visittype,
+                                                          int depth) {
+  for (int side = 0; side < 2; ++side) {
+    m_reached[side].clear();
+    m_frontier[side].clear();
+  }
+  m_path.clear();
+  m_reached[0][&from] = Reached{nullptr, 0};
+  m_reached[1][&to] = Reached{nullptr, 0};
+  m_frontier[0].push_back(&from);
+  m_frontier[1].push_back(&to);
+  if (&from == &to) {
+    m_path.push_back(&from);
+    return m_path;
+  }
+  // the forward search follows the links in the requested direction, the backward search goes against them
+  bool forwardChildren = visittype != VisitType::PARENTS;
+  bool forwardParents = visittype != VisitType::CHILDREN;
+
+  int levels[2] = {0, 0};
+  const N* meet = nullptr;
+  int best = -1;  // length of the shortest path found
+  while (meet == nullptr && !m_frontier[0].empty() && !m_frontier[1].empty() &&
+         (depth < 0 || levels[0] + levels[1] < depth)) {
+    int side = m_frontier[0].size() <= m_frontier[1].size() ? 0 : 1;
+    int other = 1 - side;
+    bool children = side == 0 ? forwardChildren : forwardParents;
+    bool parents = side == 0 ? forwardParents : forwardChildren;
+    int level = ++levels[side];
+    m_next.clear();
+    // the whole level is expanded so that the best of the meeting points is kept
+    for (auto node : m_frontier[side]) {
+      forEachLink(node, children, parents, [&](const N* next) {
+        if (!m_reached[side].emplace(next, Reached{node, level}).second) return;
+        auto found = m_reached[other].find(next);
+        if (found != m_reached[other].end()) {
+          int length = level + found->second.depth;
+          if (best < 0 || length < best) {
+            best = length;
+            meet = next;
+          }
+        }
+        m_next.push_back(next);
+      });
+    }
+    m_frontier[side].swap(m_next);
+  }
+  if (meet == nullptr || (depth >= 0 && best > depth)) return m_path;
+
+  // walk back from the meeting point to each end
+  for (const N* node = meet; node != nullptr; node = m_reached[0][node].previous)
+    m_path.push_back(node);
+  std::reverse(m_path.begin(), m_path.end());
+  for (const N* node = m_reached[1][meet].previous; node != nullptr; node = m_reached[1][node].previous)
+    m_path.push_back(node);
+  return m_path;
+}
+}
+
+#endif /* BidirectionalSearch_h */
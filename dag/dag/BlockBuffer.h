@@ -0,0 +1,49 @@
+#ifndef DAG_BLOCKBUFFER_H
+#define DAG_BLOCKBUFFER_H
+/** @class   DAG::BlockBuffer
+ *
+ *  @brief BlockBuffer stores blocks of nodes one after the other in a single array
+ *
+ *   FloodFill::fill and GraphFloodFill::fill give their blocks in a BlockBuffer rather than as a vector of
+ *   vectors: refilling the buffer for the next graph only clears the two arrays, so no memory is allocated
+ *   once they have grown to the size of the largest graph.
+ *
+ *  Example usage:
+ *
+ DAG::FloodFill<int>::Blocks blocks;  // a BlockBuffer of node pointers
+ ffill.fill(nodes, blocks);
+ for (std::size_t i = 0; i < blocks.size(); ++i)
+   std::cout << "block of " << blocks.block(i).size() << " nodes" << std::endl;
+ *
+ */
+
+#include "CompactGraph.h"
+#include <memory>
+#include <vector>
+
+namespace DAG {
+/// blocks stored one after the other in one array, so that they can be refilled without allocating
+template <typename V, typename Allocator = std::allocator<V>>  /// V is how a node is referred to
+struct BlockBuffer {
+  typedef std::vector<V, Allocator> Values;
+  typedef std::vector<std::size_t, typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t>>
+      Offsets;
+
+  Values nodes;
+  Offsets offsets;  ///< block i is nodes [offsets[i], offsets[i+1])
+
+  /// Constructor, the arrays use the allocator
+  explicit BlockBuffer(const Allocator& allocator = Allocator())
+      : nodes(allocator), offsets(1, 0, typename Offsets::allocator_type(allocator)) {}
+  std::size_t size() const { return offsets.size() - 1; }
+  ArrayRange<V> block(std::size_t i) const {
+    return ArrayRange<V>(nodes.data() + offsets[i], nodes.data() + offsets[i + 1]);
+  }
+  void clear() {
+    nodes.clear();
+    offsets.assign(1, 0);
+  }
+};
+}
+
+#endif /* BlockBuffer_h */
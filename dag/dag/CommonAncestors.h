@@ -0,0 +1,727 @@
+#ifndef DAG_COMMONANCESTORS_H
+#define DAG_COMMONANCESTORS_H
+/** @class   DAG::CommonAncestors
+ *
+ *  @brief CommonAncestors finds the closest common ancestors of two or more nodes
+ *
+ *   A common ancestor is minimal if none of its descendants is also a common ancestor (a node counts as its own
+ *   ancestor). In a DAG there may be several minimal common ancestors, lowest() returns the one with the
+ *   smallest total distance to the query nodes.
+ *
+ *   CommonAncestors works directly on the Nodes: one breadth first search per query node goes up through the
+ *   parents, always expanding the search with the smallest frontier. A node reached by all of the searches is
+ *   a common ancestor and none of the searches go past it, so the searches stop well before the top of the
+ *   graph. A final upward search from the common ancestors found removes the ones that are not minimal, it stops as
+ *   soon as a single common ancestor is left (in the worst case it goes up to the roots).
+ *
+ *   The searches of a query are tracked with the bits of a 64 bit mask. More query nodes are handled 64 at a time:
+ *   the common ancestors of a set of nodes are the ancestors of its minimal common ancestors, so the next nodes are
+ *   searched together with one search that starts from all of the minimal common ancestors found so far.
+ *
+ *   CommonAncestorIndex answers the same queries on a frozen graph (CompactGraph). It is built once, in linear
+ *   time apart from a sparse table over blocks of 32 nodes, into:
+ *    - a spanning forest where the tree parent of a node is its parent in the deepest layer. The sparse table over
+ *      the depths in pre-order gives the lowest common ancestor in the forest in constant time. This tree ancestor
+ *      of the query nodes is always a common ancestor.
+ *    - the cross parents of each node, i.e. the parents that are not its tree ancestors. The ancestors reached
+ *      through them stay in the subtree of or above each tree ancestor of the node that is deeper than its escape
+ *      depth. The nodes with cross parents on a tree path are chained by jump pointers that keep the smallest
+ *      escape depth of the nodes they skip.
+ *   If no query node has a cross parent below the tree ancestor whose escape depth reaches it, the tree ancestor is
+ *   the only minimal common ancestor. Such a query costs O(k log c) for k query nodes with c cross linked nodes on
+ *   their paths, whatever the size of the graph. Otherwise the ancestors of each query node are given by its
+ *   entries (the node and the cross parents met while jumping up to the tree ancestor). The entries of the query
+ *   nodes are intersected in the forest and the candidates that reach another one are dropped (tested with GRAIL
+ *   intervals, see ReachabilityIndex). This search costs in the cross links below the tree ancestor rather than in
+ *   the ancestors of the query nodes. Batches of queries can be run in parallel. Query nodes that are not in the
+ *   graph give no common ancestor.
+ *
+ *   The index uses 15 * 4 bytes per node, 4 bytes per cross parent and (n / 32) log2(n / 32) words for the sparse
+ *   table. Each thread that runs queries adds 3 * 4 bytes per node.
+ *
+ *  Example usage:
+ *
+ DAG::CommonAncestors<INode> ancestors;
+ for (auto node : ancestors.minimal({&n4, &n6}))
+   std::cout << node->value() << std::endl;
+ const INode* lca = ancestors.lowest(n4, n6);
+ *
+ */
+
+#include "CompactGraph.h"
+#include "ThreadPool.h"
+#include "TopologicalSort.h"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+namespace DAG {
+/// CommonAncestors finds the minimal common ancestors of a set of nodes by searching up from each of them
+template <typename N>  /// N is the Node
+class CommonAncestors {
+public:
+  CommonAncestors();
+  /// the common ancestors of the nodes that have no descendant which is also a common ancestor
+  const Nodevector<N>& minimal(const Nodevector<N>& nodes);
+  /// the minimal common ancestor closest to the two nodes (nullptr if they have no common ancestor)
+  const N* lowest(const N& a, const N& b);
+
+private:
+  struct State {
+    std::uint64_t mask;  ///< which of the searches have reached the node
+    int distance;        ///< sum of the distances to the searches that reached the node
+  };
+  std::unordered_map<const N*, State> m_state;
+  std::vector<Nodevector<N>> m_frontier;  ///< current level of each search
+  Nodevector<N> m_next;
+  Nodevector<N> m_candidates;  ///< nodes reached by all the searches
+  Nodevector<N> m_result;
+  Nodeset<N> m_above;  ///< ancestors of the candidates (used to remove the ones that are not minimal)
+
+  /// the minimal common ancestors (in m_result) of the searches starting from the nodes in m_frontier
+  void search();
+};
+
+/// CommonAncestorIndex answers common ancestor queries on a frozen graph
+template <typename N>  /// N is the Node
+class CommonAncestorIndex {
+public:
+  typedef typename CompactGraph<N>::Index Index;
+
+  CommonAncestorIndex();
+  /// preprocess the graph, returns false if it has a cycle
+  bool build(const CompactGraph<N>& graph);
+  /// the minimal common ancestors of the nodes with the given indices
+  std::vector<Index> minimal(const std::vector<Index>& nodes) { return minimal(nodes, m_scratch[0]); }
+  const Nodevector<N>& minimal(const Nodevector<N>& nodes);
+  /// the minimal common ancestor in the deepest layer (npos if there is none)
+  Index lowest(Index a, Index b);
+  /// answer many queries, in parallel if a pool is given
+  std::vector<std::vector<Index>> minimalBatch(const std::vector<std::vector<Index>>& queries,
+                                               ThreadPool* pool = nullptr);
+  /// number of queries since the build that were not answered by the forest alone
+  std::size_t searches() const;
+  /// memory used by the index in bytes (without the query scratch space)
+  std::size_t memory() const;
+
+private:
+  /// per thread search state, the stamps avoid clearing the arrays between queries
+  struct Scratch {
+    std::vector<Index> entry;    ///< the node is an entry of the current search
+    std::vector<Index> walked;   ///< the cross linked node has been walked by the current search
+    std::vector<Index> visited;  ///< the node has been visited by the current reachability search
+    Index current;
+    std::vector<Index> stack;
+    std::vector<Index> entries;
+    std::vector<Index> candidates;  ///< lowest forest ancestors common to the searches so far
+    std::vector<Index> ranks;
+    std::vector<std::pair<Index, Index>> merged;  ///< (pre-order rank, 0 for a candidate or 1 for an entry)
+    std::size_t searches;
+  };
+  static const Index block = 32;  ///< pre-order ranks per entry of the sparse table
+  const CompactGraph<N>* m_graph;
+  std::vector<Index> m_layer;
+  std::vector<Index> m_parent;    ///< tree parent (npos for a root of the forest)
+  std::vector<Index> m_depth;     ///< depth in the forest
+  std::vector<Index> m_pre;       ///< pre-order rank in the forest
+  std::vector<Index> m_subtree;   ///< size of the subtree
+  std::vector<Index> m_preorder;  ///< node of each pre-order rank
+  std::vector<Index> m_preDepth;  ///< depth of the node of each pre-order rank
+  std::vector<Index> m_sparse;    ///< rank of the smallest depth in 2^level blocks, level by level
+  std::vector<Index> m_low;       ///< GRAIL interval [low, post] of a depth first search over all the links
+  std::vector<Index> m_post;
+  std::vector<Index> m_crossOffsets;  ///< start of the cross parents of each node (plus the end)
+  std::vector<Index> m_crossParents;
+  std::vector<Index> m_crossUp;     ///< the closest node with cross parents on the tree path (npos if none)
+  std::vector<Index> m_escape;      ///< escape depth of a node with cross parents
+  std::vector<Index> m_chainDepth;  ///< number of nodes with cross parents above on the tree path
+  std::vector<Index> m_jump;        ///< jump pointer along the nodes with cross parents (itself at the top)
+  std::vector<Index> m_jumpEscape;  ///< smallest escape depth from the node up to, not including, its jump
+  std::vector<Scratch> m_scratch;
+  Nodevector<N> m_result;
+
+  std::vector<Index> minimal(const std::vector<Index>& nodes, Scratch& scratch);
+  void reset(Scratch& scratch);
+  void nextSearch(Scratch& scratch);
+  /// pre-order rank with the smallest depth in the ranks [first, last]
+  Index shallowest(Index first, Index last) const;
+  /// lowest common ancestor in the forest, npos if the nodes are in different trees
+  Index treeAncestor(Index a, Index b) const;
+  /// b is in the subtree of a
+  bool inTree(Index a, Index b) const { return m_pre[b] - m_pre[a] < m_subtree[a]; }
+  /// the next node with cross parents up the tree path
+  Index chainNext(Index node) const {
+    return m_parent[node] == CompactGraph<N>::npos ? CompactGraph<N>::npos : m_crossUp[m_parent[node]];
+  }
+  /// smallest escape depth of the nodes with cross parents on the tree path of node that are deeper than depth
+  Index escapeBelow(Index node, Index depth) const;
+  /// the entries of the search from start: start and the cross parents met below the tree ancestor top
+  void collect(Index start, Index top, Scratch& scratch);
+  /// the lowest forest ancestors common to the candidates and to the entries
+  void meet(Scratch& scratch);
+  /// keep the nodes that have none of the others in their subtree
+  void lowestInForest(std::vector<Index>& nodes, Scratch& scratch);
+  bool reaches(Index a, Index b, Scratch& scratch);
+};
+
+/// Constructor
+template <typename N>
+CommonAncestors<N>::CommonAncestors() {}
+
+/**
+ minimal common ancestors by interleaved upward breadth first searches, 64 query nodes at a time
+ @param const Nodevector<N>& nodes - the query nodes
+ @return const Nodevector<N>& - the minimal common ancestors
+ */
+template <typename N>
+const Nodevector<N>& CommonAncestors<N>::minimal(const Nodevector<N>& nodes) {
+  m_result.clear();
+  std::size_t next = std::min<std::size_t>(nodes.size(), 64);
+  m_frontier.resize(next);
+  for (std::size_t i = 0; i < next; ++i)
+    m_frontier[i].assign(1, nodes[i]);
+  search();
+  while (next < nodes.size() && !m_result.empty()) {
+    // the common ancestors so far are the ancestors of m_result, search up from all of them at once
+    std::size_t count = std::min<std::size_t>(nodes.size() - next, 63);
+    m_frontier.resize(count + 1);
+    m_frontier[0] = m_result;
+    for (std::size_t i = 0; i < count; ++i)
+      m_frontier[i + 1].assign(1, nodes[next + i]);
+    next += count;
+    search();
+  }
+  return m_result;
+}
+
+template <typename N>
+void CommonAncestors<N>::search() {
+  m_state.clear();
+  m_candidates.clear();
+  m_result.clear();
+  const std::size_t searches = m_frontier.size();
+  if (searches == 0) return;
+  const std::uint64_t all = searches == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << searches) - 1;
+
+  for (std::size_t i = 0; i < searches; ++i)
+    for (auto node : m_frontier[i]) {
+      State& state = m_state[node];
+      state.mask |= std::uint64_t(1) << i;
+      if (state.mask == all) m_candidates.push_back(node);
+    }
+  std::vector<int> level(searches, 0);
+  while (true) {
+    // expand the search with the smallest frontier by one level
+    std::size_t search = searches;
+    for (std::size_t i = 0; i < searches; ++i)
+      if (!m_frontier[i].empty() && (search == searches || m_frontier[i].size() < m_frontier[search].size()))
+        search = i;
+    if (search == searches) break;  // all searches are finished
+    const std::uint64_t bit = std::uint64_t(1) << search;
+    ++level[search];
+    m_next.clear();
+    for (auto node : m_frontier[search]) {
+      if (m_state[node].mask == all) continue;  // never search past a common ancestor
+      for (auto parent : node->parents()) {
+        State& state = m_state[parent];
+        if (state.mask & bit) continue;
+        state.mask |= bit;
+        state.distance += level[search];
+        if (state.mask == all)
+          m_candidates.push_back(parent);
+        else
+          m_next.push_back(parent);
+      }
+    }
+    m_frontier[search].swap(m_next);
+  }
+  for (auto& frontier : m_frontier)
+    frontier.clear();
+
+  if (m_candidates.size() < 2) {
+    m_result = m_candidates;
+    return;
+  }
+  // a candidate that is an ancestor of another candidate is not minimal. At least one candidate is minimal, so the
+  // walk up from the candidates stops once all but one of them have been found above the others.
+  std::size_t left = m_candidates.size();
+  m_above.clear();
+  m_next.assign(m_candidates.begin(), m_candidates.end());
+  for (std::size_t i = 0; i < m_next.size() && left > 1; ++i)
+    for (auto parent : m_next[i]->parents())
+      if (m_above.insert(parent).second) {
+        m_next.push_back(parent);
+        auto found = m_state.find(parent);
+        if (found != m_state.end() && found->second.mask == all) --left;  // every common ancestor is a candidate
+      }
+  for (auto candidate : m_candidates)
+    if (m_above.find(candidate) == m_above.end()) m_result.push_back(candidate);
+}
+
+/**
+ the closest minimal common ancestor of two nodes
+ @param const N& a
+ @param const N& b
+ @return const N* - the common ancestor with the smallest total distance to a and b, nullptr if there is none
+ */
+template <typename N>
+const N* CommonAncestors<N>::lowest(const N& a, const N& b) {
+  const N* best = nullptr;
+  for (auto node : minimal(Nodevector<N>{&a, &b}))
+    if (best == nullptr || m_state[node].distance < m_state[best].distance) best = node;
+  return best;
+}
+
+template <typename N>
+const typename CommonAncestorIndex<N>::Index CommonAncestorIndex<N>::block;
+
+/// Constructor
+template <typename N>
+CommonAncestorIndex<N>::CommonAncestorIndex() : m_graph(nullptr), m_scratch(1) {}
+
+/**
+ preprocess a frozen graph into a spanning forest with its cross parents
+ @param const CompactGraph<N>& graph - the graph must stay alive and unchanged while the index is used
+ @return bool - false if the graph has a cycle
+ */
+template <typename N>
+bool CommonAncestorIndex<N>::build(const CompactGraph<N>& graph) {
+  const Index npos = CompactGraph<N>::npos;
+  TopologicalSort<N> topo;
+  if (!topo.sort(graph)) return false;
+  m_graph = &graph;
+  const Index size = Index(graph.size());
+  const std::vector<Index>& order = topo.indexOrder();
+  m_layer.resize(size);
+  for (Index i = 0; i < size; ++i)
+    m_layer[i] = topo.layer(i);
+
+  // spanning forest, parents come before their children in the topological order
+  m_parent.assign(size, npos);
+  m_depth.assign(size, 0);
+  std::vector<Index> childOffsets(size + 1, 0);
+  for (Index node : order) {
+    for (Index parent : graph.parents(node))
+      if (m_parent[node] == npos || m_layer[parent] > m_layer[m_parent[node]]) m_parent[node] = parent;
+    if (m_parent[node] != npos) {
+      m_depth[node] = m_depth[m_parent[node]] + 1;
+      ++childOffsets[m_parent[node] + 1];
+    }
+  }
+  for (Index i = 0; i < size; ++i)
+    childOffsets[i + 1] += childOffsets[i];
+  std::vector<Index> children(size);
+  std::vector<Index> fill(childOffsets.begin(), childOffsets.end() - 1);
+  for (Index node : order)
+    if (m_parent[node] != npos) children[fill[m_parent[node]]++] = node;
+
+  m_pre.resize(size);
+  m_preorder.resize(size);
+  m_preDepth.resize(size);
+  m_subtree.assign(size, 1);
+  std::vector<Index> stack;
+  Index rank = 0;
+  for (Index root : order) {
+    if (m_parent[root] != npos) continue;
+    stack.assign(1, root);
+    while (!stack.empty()) {
+      Index node = stack.back();
+      stack.pop_back();
+      m_pre[node] = rank;
+      m_preorder[rank] = node;
+      m_preDepth[rank++] = m_depth[node];
+      for (Index i = childOffsets[node + 1]; i > childOffsets[node]; --i)
+        stack.push_back(children[i - 1]);
+    }
+  }
+  for (Index i = size; i > 0; --i) {
+    Index node = m_preorder[i - 1];
+    if (m_parent[node] != npos) m_subtree[m_parent[node]] += m_subtree[node];
+  }
+
+  // sparse table over blocks of ranks
+  const Index blocks = (size + block - 1) / block;
+  m_sparse.assign(blocks, 0);
+  for (Index b = 0; b < blocks; ++b)
+    m_sparse[b] = shallowest(b * block, std::min(size, (b + 1) * block) - 1);
+  for (Index width = 1; 2 * width <= blocks; width *= 2) {
+    const Index* previous = m_sparse.data() + m_sparse.size() - blocks;
+    std::vector<Index> level(blocks, 0);
+    for (Index b = 0; b + 2 * width <= blocks; ++b)
+      level[b] = m_preDepth[previous[b + width]] < m_preDepth[previous[b]] ? previous[b + width] : previous[b];
+    m_sparse.insert(m_sparse.end(), level.begin(), level.end());
+  }
+
+  // cross parents, and the escape depths in topological order (the tree path above a node is done before it)
+  m_crossOffsets.assign(1, 0);
+  m_crossOffsets.reserve(size + 1);
+  m_crossParents.clear();
+  for (Index node = 0; node < size; ++node) {
+    for (Index parent : graph.parents(node))
+      if (parent != m_parent[node] && !inTree(parent, node)) m_crossParents.push_back(parent);
+    m_crossOffsets.push_back(Index(m_crossParents.size()));
+  }
+  m_crossUp.assign(size, npos);
+  m_escape.assign(size, npos);
+  m_chainDepth.assign(size, 0);
+  m_jump.assign(size, npos);
+  m_jumpEscape.assign(size, npos);
+  for (Index node : order) {
+    if (m_crossOffsets[node] == m_crossOffsets[node + 1]) {
+      if (m_parent[node] != npos) m_crossUp[node] = m_crossUp[m_parent[node]];
+      continue;
+    }
+    // the ancestors through a cross parent leave the subtree of the tree ancestors that are not deeper than the
+    // common tree ancestor, or than the escape depth of a node with cross parents on the path in between
+    Index escape = npos;
+    for (Index i = m_crossOffsets[node]; i < m_crossOffsets[node + 1] && escape > 0; ++i) {
+      Index parent = m_crossParents[i];
+      Index ancestor = treeAncestor(parent, node);
+      if (ancestor == npos)
+        escape = 0;
+      else
+        escape = std::min(escape, std::min(m_depth[ancestor], escapeBelow(parent, m_depth[ancestor])));
+    }
+    m_crossUp[node] = node;
+    m_escape[node] = escape;
+    Index next = chainNext(node);
+    if (next == npos) {
+      m_jump[node] = node;
+      continue;
+    }
+    // jump pointers with logarithmic search time, see Myers, "An applicative random-access stack" (1983)
+    m_chainDepth[node] = m_chainDepth[next] + 1;
+    Index jump = m_jump[next];
+    if (m_chainDepth[next] - m_chainDepth[jump] == m_chainDepth[jump] - m_chainDepth[m_jump[jump]]) {
+      m_jump[node] = m_jump[jump];
+      m_jumpEscape[node] = std::min(escape, std::min(m_jumpEscape[next], m_jumpEscape[jump]));
+    } else {
+      m_jump[node] = next;
+      m_jumpEscape[node] = escape;
+    }
+  }
+
+  // GRAIL interval of a depth first search from the roots
+  m_low.assign(size, npos);
+  m_post.assign(size, 0);
+  std::vector<std::pair<Index, Index>> frames;  // (node, next child)
+  Index post = 0;
+  for (Index root : order) {
+    if (m_layer[root] != 0) break;
+    frames.emplace_back(root, 0);
+    m_low[root] = 0;  // on the stack
+    while (!frames.empty()) {
+      Index node = frames.back().first;
+      auto links = graph.children(node);
+      if (frames.back().second < links.size()) {
+        Index child = links[frames.back().second++];
+        if (m_low[child] == npos) {
+          m_low[child] = 0;
+          frames.emplace_back(child, 0);
+        }
+        continue;
+      }
+      frames.pop_back();
+      m_post[node] = post++;
+      Index low = m_post[node];
+      for (Index child : links)
+        low = std::min(low, m_low[child]);
+      m_low[node] = low;
+    }
+  }
+
+  for (auto& scratch : m_scratch)
+    reset(scratch);
+  return true;
+}
+
+template <typename N>
+void CommonAncestorIndex<N>::reset(Scratch& scratch) {
+  std::size_t size = m_graph ? m_graph->size() : 0;
+  scratch.entry.assign(size, 0);
+  scratch.walked.assign(size, 0);
+  scratch.visited.assign(size, 0);
+  scratch.current = 0;
+  scratch.searches = 0;
+}
+
+template <typename N>
+void CommonAncestorIndex<N>::nextSearch(Scratch& scratch) {
+  if (++scratch.current == 0) {  // the stamps have wrapped around
+    std::fill(scratch.entry.begin(), scratch.entry.end(), 0);
+    std::fill(scratch.walked.begin(), scratch.walked.end(), 0);
+    std::fill(scratch.visited.begin(), scratch.visited.end(), 0);
+    scratch.current = 1;
+  }
+}
+
+template <typename N>
+typename CommonAncestorIndex<N>::Index CommonAncestorIndex<N>::shallowest(Index first, Index last) const {
+  auto lower = [this](Index a, Index b) { return m_preDepth[b] < m_preDepth[a] ? b : a; };
+  Index best = first;
+  const Index firstBlock = first / block, lastBlock = last / block;
+  if (lastBlock - firstBlock < 2) {
+    for (Index rank = first + 1; rank <= last; ++rank)
+      best = lower(best, rank);
+    return best;
+  }
+  for (Index rank = first + 1; rank < (firstBlock + 1) * block; ++rank)
+    best = lower(best, rank);
+  for (Index rank = lastBlock * block; rank <= last; ++rank)
+    best = lower(best, rank);
+  // the blocks in between are covered by two overlapping entries of the sparse table
+  const Index from = firstBlock + 1, count = lastBlock - from;
+  Index level = 0;
+  while (Index(2) << level <= count)
+    ++level;
+  const Index* row = m_sparse.data() + std::size_t(level) * ((m_preDepth.size() + block - 1) / block);
+  best = lower(best, row[from]);
+  return lower(best, row[from + count - (Index(1) << level)]);
+}
+
+template <typename N>
+typename CommonAncestorIndex<N>::Index CommonAncestorIndex<N>::treeAncestor(Index a, Index b) const {
+  if (a == b) return a;
+  if (m_pre[a] > m_pre[b]) std::swap(a, b);
+  if (inTree(a, b)) return a;
+  // the shallowest node between them in pre-order is a child of the common ancestor (or a root)
+  return m_parent[m_preorder[shallowest(m_pre[a] + 1, m_pre[b])]];
+}
+
+template <typename N>
+typename CommonAncestorIndex<N>::Index CommonAncestorIndex<N>::escapeBelow(Index node, Index depth) const {
+  Index escape = CompactGraph<N>::npos;
+  Index next = m_crossUp[node];
+  while (next != CompactGraph<N>::npos && m_depth[next] > depth) {
+    Index jump = m_jump[next];
+    if (jump != next && m_depth[jump] > depth) {
+      escape = std::min(escape, m_jumpEscape[next]);
+      next = jump;
+    } else {
+      escape = std::min(escape, m_escape[next]);
+      next = chainNext(next);
+    }
+  }
+  return escape;
+}
+
+/**
+ minimal common ancestors, from the forest if no cross parent escapes past the tree ancestor, else by a search
+ @param const std::vector<Index>& nodes - the query nodes
+ @param Scratch& scratch - search state
+ @return std::vector<Index> - the minimal common ancestors, none if a query node is not in the graph
+ */
+template <typename N>
+std::vector<typename CommonAncestorIndex<N>::Index> CommonAncestorIndex<N>::minimal(const std::vector<Index>& nodes,
+                                                                                    Scratch& scratch) {
+  const Index npos = CompactGraph<N>::npos;
+  std::vector<Index> result;
+  for (Index node : nodes)
+    if (node >= m_layer.size()) return result;  // also CompactGraph::npos
+  if (nodes.empty()) return result;
+  Index top = nodes[0];
+  for (std::size_t i = 1; i < nodes.size() && top != npos; ++i)
+    top = treeAncestor(top, nodes[i]);
+  if (top != npos) {
+    // the ancestors of each query node are in the subtree of top or are ancestors of top
+    bool contained = true;
+    if (std::find(nodes.begin(), nodes.end(), top) == nodes.end())
+      for (Index node : nodes)
+        if (escapeBelow(node, m_depth[top]) <= m_depth[top]) {
+          contained = false;
+          break;
+        }
+    if (contained) {
+      result.push_back(top);
+      return result;
+    }
+  }
+
+  ++scratch.searches;
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    collect(nodes[i], top, scratch);
+    if (i == 0) {
+      scratch.candidates.swap(scratch.entries);
+      lowestInForest(scratch.candidates, scratch);
+    } else {
+      meet(scratch);
+    }
+    if (scratch.candidates.empty()) return result;
+  }
+  // a candidate that reaches another one is not minimal, the deepest candidates are minimal
+  std::sort(scratch.candidates.begin(), scratch.candidates.end(),
+            [this](Index a, Index b) { return m_layer[a] > m_layer[b]; });
+  for (Index candidate : scratch.candidates) {
+    bool below = true;
+    for (Index found : result)
+      if (reaches(candidate, found, scratch)) {
+        below = false;
+        break;
+      }
+    if (below) result.push_back(candidate);
+  }
+  return result;
+}
+
+/**
+ the entries of a search: every ancestor of start is on the tree path of an entry
+ @param Index start - the query node
+ @param Index top - the tree ancestor of the query nodes (npos if there is none)
+ @param Scratch& scratch - the entries are left in scratch.entries
+ */
+template <typename N>
+void CommonAncestorIndex<N>::collect(Index start, Index top, Scratch& scratch) {
+  const Index npos = CompactGraph<N>::npos;
+  nextSearch(scratch);
+  scratch.entries.clear();
+  scratch.stack.assign(1, start);
+  scratch.entry[start] = scratch.current;
+  while (!scratch.stack.empty()) {
+    Index entry = scratch.stack.back();
+    scratch.stack.pop_back();
+    scratch.entries.push_back(entry);
+    // the cross parents at or above the tree ancestor with top only lead to ancestors of top
+    Index stop = top == npos ? npos : treeAncestor(entry, top);
+    for (Index node = m_crossUp[entry]; node != npos && (stop == npos || m_depth[node] > m_depth[stop]);
+         node = chainNext(node)) {
+      if (scratch.walked[node] == scratch.current) break;  // the rest of the path has been walked
+      scratch.walked[node] = scratch.current;
+      for (Index i = m_crossOffsets[node]; i < m_crossOffsets[node + 1]; ++i) {
+        Index parent = m_crossParents[i];
+        if (scratch.entry[parent] == scratch.current || (top != npos && inTree(parent, top))) continue;
+        scratch.entry[parent] = scratch.current;
+        scratch.stack.push_back(parent);
+      }
+    }
+  }
+}
+
+template <typename N>
+void CommonAncestorIndex<N>::meet(Scratch& scratch) {
+  // the lowest common forest ancestors of two sets are among those of the neighbours in pre-order
+  scratch.merged.clear();
+  for (Index node : scratch.candidates)
+    scratch.merged.emplace_back(m_pre[node], 0);
+  for (Index node : scratch.entries)
+    scratch.merged.emplace_back(m_pre[node], 1);
+  std::sort(scratch.merged.begin(), scratch.merged.end());
+  scratch.candidates.clear();
+  for (std::size_t i = 1; i < scratch.merged.size(); ++i)
+    if (scratch.merged[i].second != scratch.merged[i - 1].second) {
+      Index ancestor =
+          treeAncestor(m_preorder[scratch.merged[i - 1].first], m_preorder[scratch.merged[i].first]);
+      if (ancestor != CompactGraph<N>::npos) scratch.candidates.push_back(ancestor);
+    }
+  lowestInForest(scratch.candidates, scratch);
+}
+
+template <typename N>
+void CommonAncestorIndex<N>::lowestInForest(std::vector<Index>& nodes, Scratch& scratch) {
+  scratch.ranks.clear();
+  for (Index node : nodes)
+    scratch.ranks.push_back(m_pre[node]);
+  std::sort(scratch.ranks.begin(), scratch.ranks.end());
+  scratch.ranks.erase(std::unique(scratch.ranks.begin(), scratch.ranks.end()), scratch.ranks.end());
+  nodes.clear();
+  for (std::size_t i = 0; i < scratch.ranks.size(); ++i) {
+    Index node = m_preorder[scratch.ranks[i]];
+    if (i + 1 == scratch.ranks.size() || scratch.ranks[i + 1] - scratch.ranks[i] >= m_subtree[node])
+      nodes.push_back(node);
+  }
+}
+
+/**
+ a is an ancestor of b, by the layers, the GRAIL interval and the forest or else a pruned depth first search
+ @param Index a
+ @param Index b
+ @param Scratch& scratch - search state
+ @return bool
+ */
+template <typename N>
+bool CommonAncestorIndex<N>::reaches(Index a, Index b, Scratch& scratch) {
+  auto excluded = [&](Index node) {
+    return m_layer[node] >= m_layer[b] || m_post[b] > m_post[node] || m_post[b] < m_low[node];
+  };
+  if (a == b) return true;
+  if (excluded(a)) return false;
+  if (inTree(a, b)) return true;
+  nextSearch(scratch);
+  scratch.stack.assign(1, a);
+  while (!scratch.stack.empty()) {
+    Index node = scratch.stack.back();
+    scratch.stack.pop_back();
+    for (Index child : m_graph->children(node)) {
+      if (child == b || inTree(child, b)) return true;
+      if (scratch.visited[child] == scratch.current || excluded(child)) continue;
+      scratch.visited[child] = scratch.current;
+      scratch.stack.push_back(child);
+    }
+  }
+  return false;
+}
+
+template <typename N>
+const Nodevector<N>& CommonAncestorIndex<N>::minimal(const Nodevector<N>& nodes) {
+  m_result.clear();
+  if (m_graph == nullptr) return m_result;
+  std::vector<Index> indices;
+  for (auto node : nodes)
+    indices.push_back(m_graph->index(node));  // npos for a node that is not in the graph, see minimal() above
+  for (Index i : minimal(indices, m_scratch[0]))
+    m_result.push_back(m_graph->node(i));
+  return m_result;
+}
+
+template <typename N>
+typename CommonAncestorIndex<N>::Index CommonAncestorIndex<N>::lowest(Index a, Index b) {
+  Index best = CompactGraph<N>::npos;
+  for (Index node : minimal(std::vector<Index>{a, b}, m_scratch[0]))
+    if (best == CompactGraph<N>::npos || m_layer[node] > m_layer[best]) best = node;
+  return best;
+}
+
+/**
+ answer a batch of queries, each thread of the pool has its own search state
+ @param const std::vector<std::vector<Index>>& queries - the query nodes of each query
+ @param ThreadPool* pool - optional
+ @return std::vector<std::vector<Index>> - the minimal common ancestors of each query
+ */
+template <typename N>
+std::vector<std::vector<typename CommonAncestorIndex<N>::Index>> CommonAncestorIndex<N>::minimalBatch(
+    const std::vector<std::vector<Index>>& queries, ThreadPool* pool) {
+  std::vector<std::vector<Index>> results(queries.size());
+  std::size_t chunks = pool ? pool->size() : 1;
+  while (m_scratch.size() < chunks) {
+    m_scratch.emplace_back();
+    reset(m_scratch.back());
+  }
+  auto run = [&](std::size_t begin, std::size_t end, unsigned chunk) {
+    for (std::size_t i = begin; i < end; ++i)
+      results[i] = minimal(queries[i], m_scratch[chunk]);
+  };
+  if (pool)
+    pool->parallelFor(queries.size(), run);
+  else
+    run(0, queries.size(), 0);
+  return results;
+}
+
+template <typename N>
+std::size_t CommonAncestorIndex<N>::searches() const {
+  std::size_t searches = 0;
+  for (const auto& scratch : m_scratch)
+    searches += scratch.searches;
+  return searches;
+}
+
+template <typename N>
+std::size_t CommonAncestorIndex<N>::memory() const {
+  std::size_t words = m_layer.size() + m_parent.size() + m_depth.size() + m_pre.size() + m_subtree.size() +
+                      m_preorder.size() + m_preDepth.size() + m_sparse.size() + m_low.size() + m_post.size() +
+                      m_crossOffsets.size() + m_crossParents.size() + m_crossUp.size() + m_escape.size() +
+                      m_chainDepth.size() + m_jump.size() + m_jumpEscape.size();
+  return words * sizeof(Index);
+}
+}
+
+#endif /* CommonAncestors_h */
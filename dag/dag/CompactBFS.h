@@ -0,0 +1,192 @@
+#ifndef DAG_COMPACTBFS_H
+#define DAG_COMPACTBFS_H
+/** @class   DAG::CompactBFS
+ *
+ *  @brief CompactBFS is a breadth first search over a CompactGraph
+ *
+ *   The search works on node indices and can be given a link predicate, called with the node being expanded
+ *   and the link (CompactLink) about to be followed. The link carries its position in the link arrays, so the
+ *   predicate can read the link weight or any EdgeColumn attribute directly, from the same position as the
+ *   link target. Links for which the predicate returns false are not followed.
+ *
+ *   A TagMask can be given instead of a predicate, the search then only enters nodes whose type tag (see
+ *   CompactGraph::setTags) is in the mask. Only the tag array is read, never the payloads, so a typed query
+ *   ("the clusters below this track") costs no more than an untyped one and needs no filtering afterwards.
+ *
+ *   On a LayeredGraph the search follows the links of the layers selected by a LayerMask (all of them by
+ *   default), and CompactLink::layer tells the predicate which layer a link belongs to.
+ *
+ *   Results are given level by level (levelOffsets) and the buffers are kept between searches. The search itself
+ *   is that of GraphBFS over the CompactGraph, CompactBFS gives it the links to follow.
+ *
+ *   On graphs that do not fit in the cache each node expanded waits for its offsets, its links and the visited
+ *   marks of its links to be loaded. After setPrefetchDistance(d) the search starts loading the offsets of the
+ *   node d places ahead in the queue, the links of the node d/2 places ahead and the visited marks of the links
+ *   of the next node, so that these loads overlap (only the links of layer 0 of a LayeredGraph are prefetched).
+ *
+ *  Example usage:
+ *
+ DAG::CompactGraph<INode> graph(nodes);
+ DAG::EdgeColumn<int> linkType(graph, [](const INode* parent, const INode* child) { return type(parent, child); });
+ DAG::CompactBFS<INode> bfs(graph);
+ // only follow links of type 1
+ for (auto i : bfs.traverse(graph.index(&n0), DAG::VisitType::UNDIRECTED, -1,
+                             [&](unsigned from, const DAG::CompactLink& link) { return linkType[link] == 1; }))
+   std::cout << graph.node(i)->value() << std::endl;
+ // only go through tracks (tag 0) and clusters (tag 1)
+ graph.setTags([](const INode* node) { return node->value() % 3; });
+ bfs.traverse(graph.index(&n0), DAG::VisitType::CHILDREN, -1, DAG::TagMask{0, 1});
+ *
+ */
+
+#include "CompactGraph.h"
+#include "GraphBFS.h"
+#include "LayeredGraph.h"
+#include "Prefetch.h"
+
+namespace DAG {
+/// CompactBFS is a breadth first search over the node indices of a CompactGraph
+template <typename N>  /// N is the Node
+class CompactBFS {
+public:
+  typedef typename CompactGraph<N>::Index Index;
+
+  explicit CompactBFS(const CompactGraph<N>& graph);
+  /// search the links of the selected layers of a LayeredGraph
+  explicit CompactBFS(const LayeredGraph<N>& graph, LayerMask layers = LayerMask::all());
+  void setLayers(LayerMask layers) { m_layers = layers; }
+  /// visit everything linked to the start node(s) (depth -1 = everything, 0 = start node(s) only)
+  const std::vector<Index>& traverse(Index start, VisitType visittype, int depth = -1);
+  /// as above but only following the links for which follow(from, link) is true
+  template <typename P>
+  const std::vector<Index>& traverse(Index start, VisitType visittype, int depth, P follow);
+  template <typename P>
+  const std::vector<Index>& traverse(const std::vector<Index>& starts, VisitType visittype, int depth, P follow);
+  /// as above but only entering the nodes whose tag is in the mask (the start nodes are always visited)
+  const std::vector<Index>& traverse(Index start, VisitType visittype, int depth, TagMask allowed);
+  const std::vector<Index>& traverse(const std::vector<Index>& starts, VisitType visittype, int depth,
+                                     TagMask allowed);
+
+  /// the nodes found by the last search
+  const std::vector<Index>& result() const { return m_search.result(); }
+  /// level k is found at [levelOffsets()[k], levelOffsets()[k+1]) in the results
+  const std::vector<std::size_t>& levelOffsets() const { return m_search.levelOffsets(); }
+  bool visited(Index i) const { return m_search.visited(i); }
+  /// prefetch what the nodes this many places ahead in the queue will need (0 = no prefetching)
+  void setPrefetchDistance(unsigned distance) { m_prefetch = distance; }
+  unsigned prefetchDistance() const { return m_prefetch; }
+
+protected:
+  const CompactGraph<N>* m_graph;
+  const LayeredGraph<N>* m_layered;         ///< the graph holding m_graph as its layer 0, otherwise nullptr
+  LayerMask m_layers;                       ///< the layers that are followed
+  GraphBFS<CompactGraph<N>> m_search;       ///< the queue and visited marks
+  std::vector<Index> m_start;               ///< the start node of a search from a single node
+  unsigned m_prefetch;                      ///< prefetch distance in the queue (0 = off)
+
+  /// start loading what the nodes queued after position k will need when they are expanded
+  void prefetchAhead(std::size_t k, VisitType visittype) const;
+};
+
+/// Constructor
+template <typename N>
+CompactBFS<N>::CompactBFS(const CompactGraph<N>& graph)
+    : m_graph(&graph), m_layered(nullptr), m_layers(LayerMask::all()), m_search(graph), m_prefetch(0) {}
+
+/// Constructor
+template <typename N>
+CompactBFS<N>::CompactBFS(const LayeredGraph<N>& graph, LayerMask layers)
+    : m_graph(&graph.graph()), m_layered(&graph), m_layers(layers), m_search(graph.graph()), m_prefetch(0) {}
+
+/**
+ prefetch in three steps so that each load only uses addresses that earlier steps brought into the cache:
+ the offsets of the node far ahead, the links of a node half way, the visited marks of the next node's links
+ @param std::size_t k - position in the queue of the node about to be expanded
+ @param VisitType visittype - the links that are followed
+ @return void
+ */
+template <typename N>
+void CompactBFS<N>::prefetchAhead(std::size_t k, VisitType visittype) const {
+  const CompactGraph<N>& graph = *m_graph;
+  const std::vector<Index>& queue = m_search.result();
+  const bool children = visittype != VisitType::PARENTS;
+  const bool parents = visittype != VisitType::CHILDREN;
+  if (k + m_prefetch < queue.size()) {
+    Index far = queue[k + m_prefetch];
+    if (children) prefetch(&graph.childOffsets()[far]);
+    if (parents) prefetch(&graph.parentOffsets()[far]);
+  }
+  std::size_t half = k + (m_prefetch + 1) / 2;
+  if (half < queue.size()) {
+    Index node = queue[half];
+    if (children) prefetch(graph.children(node).begin());
+    if (parents) prefetch(graph.parents(node).begin());
+  }
+  std::size_t near = k + (m_prefetch + 3) / 4;
+  if (near < queue.size()) {
+    Index next = queue[near];
+    if (children)
+      for (Index link : graph.children(next))
+        m_search.prefetchVisited(link);
+    if (parents)
+      for (Index link : graph.parents(next))
+        m_search.prefetchVisited(link);
+  }
+}
+
+template <typename N>
+const std::vector<typename CompactBFS<N>::Index>& CompactBFS<N>::traverse(Index start, VisitType visittype,
+                                                                          int depth) {
+  return traverse(start, visittype, depth, [](Index, const CompactLink&) { return true; });
+}
+
+template <typename N>
+template <typename P>
+const std::vector<typename CompactBFS<N>::Index>& CompactBFS<N>::traverse(Index start, VisitType visittype,
+                                                                          int depth, P follow) {
+  m_start.assign(1, start);
+  return traverse(m_start, visittype, depth, follow);
+}
+
+template <typename N>
+const std::vector<typename CompactBFS<N>::Index>& CompactBFS<N>::traverse(Index start, VisitType visittype,
+                                                                          int depth, TagMask allowed) {
+  m_start.assign(1, start);
+  return traverse(m_start, visittype, depth, allowed);
+}
+
+template <typename N>
+const std::vector<typename CompactBFS<N>::Index>& CompactBFS<N>::traverse(const std::vector<Index>& starts,
+                                                                          VisitType visittype, int depth,
+                                                                          TagMask allowed) {
+  const auto* tags = m_graph->tags().data();
+  return traverse(starts, visittype, depth,
+                  [tags, allowed](Index, const CompactLink& link) { return allowed.contains(tags[link.node]); });
+}
+
+/**
+ level by level breadth first search (see GraphBFS::search)
+ @param const std::vector<Index>& starts - the start node(s)
+ @param VisitType visittype - CHILDREN/PARENTS/UNDIRECTED
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @param P follow - follow(Index from, const CompactLink& link) returns true if the link is to be followed
+ @return const std::vector<Index>& - the nodes found, level by level
+ */
+template <typename N>
+template <typename P>
+const std::vector<typename CompactBFS<N>::Index>& CompactBFS<N>::traverse(const std::vector<Index>& starts,
+                                                                          VisitType visittype, int depth, P follow) {
+  return m_search.search(starts, depth, [&](std::size_t k, Index node, auto add) {
+    if (m_prefetch) prefetchAhead(k, visittype);
+    auto visit = [&](const CompactLink& link) {
+      if (!m_search.visited(link.node) && follow(node, link)) add(link.node);
+    };
+    if (m_layered)
+      m_layered->forEachLink(node, visittype, m_layers, visit);
+    else
+      m_graph->forEachLink(node, visittype, visit);
+  });
+}
+}
+
+#endif /* CompactBFS_h */
@@ -0,0 +1,471 @@
+#ifndef DAG_COMPACTGRAPH_H
+#define DAG_COMPACTGRAPH_H
+/** @class   DAG::CompactGraph
+ *
+ *  @brief CompactGraph is a frozen copy of the links between a set of Nodes, stored as dense arrays
+ *
+ *   Each node of the set is given an index 0..size()-1 and the children and parents of node i are stored
+ *   contiguously (compressed sparse row layout) as indices. Algorithms that need to run several passes over
+ *   the same graph (sorting, indexing, ...) work on this representation instead of the hash sets of Node.
+ *   Links to nodes outside of the set are dropped. The CompactGraph does not follow later changes to the
+ *   Nodes, it has to be rebuilt.
+ *
+ *   A weight can be given to each link when the graph is built, the weights are stored in arrays parallel to
+ *   the child and parent indices. Further typed link attributes can be stored the same way in EdgeColumns.
+ *
+ *   The arrays only hold the topology, the payloads (Node::value()) stay in the Nodes. Traversals of the
+ *   CompactGraph (CompactBFS, TopologicalSort, ...) therefore never load payload bytes into the cache. The
+ *   payloads or the parts of them that an algorithm needs can be copied into a NodeColumn, a separate array
+ *   addressed by node index (hot topology, cold payload).
+ *
+ *   The indices can be renumbered with permute() (see Reordering.h) so that nodes that are searched together
+ *   sit next to each other in the arrays.
+ *
+ *   Each node also has a one byte type tag (0 unless setTags is called), stored in an array next to the
+ *   offsets. Traversals can be restricted to some node types with a TagMask and then read only this array.
+ *
+ *  Example usage:
+ *
+ typedef DAG::Node<int> INode;
+ INode n0(0), n1(1);
+ n0.addChild(n1);
+ DAG::CompactGraph<INode> graph(DAG::CompactGraph<INode>::connected(n0));
+ for (auto child : graph.children(graph.index(&n0)))
+   std::cout << graph.node(child)->value() << std::endl;
+ *
+ */
+
+#include "DirectedAcyclicGraph.h"
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+
+namespace DAG {
+/// a contiguous range of an array of a CompactGraph (eg the child indices or link weights of one node)
+template <typename I>
+class ArrayRange {
+public:
+  ArrayRange(const I* first, const I* last) : m_first(first), m_last(last) {}
+  const I* begin() const { return m_first; }
+  const I* end() const { return m_last; }
+  std::size_t size() const { return m_last - m_first; }
+  bool empty() const { return m_first == m_last; }
+  I operator[](std::size_t i) const { return m_first[i]; }
+
+private:
+  const I* m_first;
+  const I* m_last;
+};
+
+/// one link as seen from a node of a CompactGraph: where it goes and its position in the link arrays
+struct CompactLink {
+  unsigned int node;   ///< index of the node at the other end of the link
+  unsigned int slot;   ///< position of the link in the child array (or parent array if toParent)
+  bool toParent;       ///< true if the link goes to a parent
+  unsigned int layer;  ///< edge layer of the link (see LayeredGraph), always 0 for a CompactGraph
+};
+
+template <typename N>
+class CompactGraph;
+
+/// EdgeColumn stores one attribute per link of a CompactGraph
+/**
+ * The values are stored in two arrays laid out exactly like the child and parent index arrays, so the
+ * attribute of a link is found at the same position as the link itself (structure of arrays).
+ * NB use char rather than bool for flags (std::vector<bool> does not store values).
+ */
+template <typename A>  /// A is the type of the attribute
+class EdgeColumn {
+public:
+  EdgeColumn() {}
+  /// fill the column, attribute(parent, child) is called twice for each link of the graph (child and parent array)
+  template <typename N, typename F>
+  EdgeColumn(const CompactGraph<N>& graph, F attribute) {
+    build(graph, attribute);
+  }
+  template <typename N, typename F>
+  void build(const CompactGraph<N>& graph, F attribute);
+  void clear() {
+    m_child.clear();
+    m_parent.clear();
+  }
+  bool empty() const { return m_child.empty(); }
+  /// move the values to the new link positions, slots[new position] being the old position (as given by
+  /// CompactGraph::permute)
+  void permute(const std::vector<unsigned int>& childSlots, const std::vector<unsigned int>& parentSlots);
+
+  /// attribute of a link given as a position in the child (or parent) array
+  const A& child(std::size_t slot) const { return m_child[slot]; }
+  const A& parent(std::size_t slot) const { return m_parent[slot]; }
+  /// attribute of a link of the CompactGraph (its slots are only those of layer 0 of a LayeredGraph)
+  const A& operator[](const CompactLink& link) const {
+    assert(link.layer == 0 && "an EdgeColumn only holds the links of layer 0");
+    return link.toParent ? m_parent[link.slot] : m_child[link.slot];
+  }
+  /// the values parallel to the child and parent arrays
+  const std::vector<A>& childColumn() const { return m_child; }
+  const std::vector<A>& parentColumn() const { return m_parent; }
+
+private:
+  std::vector<A> m_child;   ///< parallel to the child index array
+  std::vector<A> m_parent;  ///< parallel to the parent index array
+};
+
+/// NodeColumn stores one value per node of a CompactGraph, addressed by node index
+/**
+ * Used to keep payloads (or the fields of them that are needed) in an array of their own, apart from the
+ * topology, so that traversals and payload processing each only touch the memory they use.
+ */
+template <typename A>  /// A is the type of the value
+class NodeColumn {
+public:
+  NodeColumn() {}
+  /// fill the column, value(node) is called once for each node of the graph in index order
+  template <typename N, typename F>
+  NodeColumn(const CompactGraph<N>& graph, F value) {
+    build(graph, value);
+  }
+  template <typename N, typename F>
+  void build(const CompactGraph<N>& graph, F value);
+  void clear() { m_values.clear(); }
+  bool empty() const { return m_values.empty(); }
+  std::size_t size() const { return m_values.size(); }
+
+  const A& operator[](std::size_t i) const { return m_values[i]; }
+  A& operator[](std::size_t i) { return m_values[i]; }
+  /// follow a renumbering of the nodes, order[new index] being the old index (see CompactGraph::permute)
+  void permute(const std::vector<unsigned int>& order);
+  const std::vector<A>& values() const { return m_values; }
+
+private:
+  std::vector<A> m_values;  ///< parallel to the nodes of the graph
+};
+
+/**
+ renumber the nodes of compressed sparse row arrays: node k gets the links of node order[k]
+ @param const std::vector<I>& order - old index of each new index
+ @param const std::vector<I>& newIndex - new index of each old index
+ @param std::vector<I>& offsets - start of the links of each node (plus the end), replaced
+ @param std::vector<I>& targets - the other end of each link, replaced
+ @param std::vector<I>& slots - set to the old position of each link
+ @return void
+ */
+template <typename I>
+void permuteLinks(const std::vector<I>& order, const std::vector<I>& newIndex, std::vector<I>& offsets,
+                  std::vector<I>& targets, std::vector<I>& slots) {
+  std::vector<I> newOffsets(1, 0);
+  std::vector<I> newTargets;
+  newOffsets.reserve(offsets.size());
+  newTargets.reserve(targets.size());
+  slots.clear();
+  slots.reserve(targets.size());
+  for (I old : order) {
+    for (I slot = offsets[old]; slot < offsets[old + 1]; ++slot) {
+      newTargets.push_back(newIndex[targets[slot]]);
+      slots.push_back(slot);
+    }
+    newOffsets.push_back(newTargets.size());
+  }
+  offsets.swap(newOffsets);
+  targets.swap(newTargets);
+}
+
+/// TagMask is a set of node type tags (0..63), used to restrict a traversal to some types of node
+class TagMask {
+public:
+  TagMask() : m_bits(0) {}
+  TagMask(std::initializer_list<unsigned> tags) : m_bits(0) {
+    for (unsigned tag : tags)
+      add(tag);
+  }
+  /// every tag
+  static TagMask all() { return TagMask(~std::uint64_t(0)); }
+  TagMask& add(unsigned tag) {
+    assert(tag < 64 && "a TagMask holds the tags 0..63");
+    m_bits |= std::uint64_t(1) << tag;
+    return *this;
+  }
+  /// false for a tag that is not 0..63
+  bool contains(unsigned tag) const { return tag < 64 && ((m_bits >> tag) & 1); }
+  std::uint64_t bits() const { return m_bits; }
+
+private:
+  explicit TagMask(std::uint64_t bits) : m_bits(bits) {}
+  std::uint64_t m_bits;
+};
+
+/// CompactGraph stores the links of a set of nodes as index arrays
+template <typename N>  /// N is the Node
+class CompactGraph {
+public:
+  typedef unsigned int Index;
+  typedef unsigned char Tag;  ///< node type tag, 0..63 so that it fits a TagMask
+  typedef ArrayRange<Index> Range;
+  typedef ArrayRange<double> WeightRange;
+  /// gives the weight of the link parent -> child
+  typedef std::function<double(const N* parent, const N* child)> WeightFunction;
+  static const Index npos = ~Index(0);  ///< index of a node that is not in the graph
+
+  CompactGraph();
+  /// freeze the links between the given nodes
+  explicit CompactGraph(const Nodevector<N>& nodes);
+  /// freeze the links between the given nodes together with a weight for each link
+  CompactGraph(const Nodevector<N>& nodes, const WeightFunction& weight);
+  void build(const Nodevector<N>& nodes);
+  void build(const Nodevector<N>& nodes, const WeightFunction& weight);
+  /// all the nodes that are linked (undirected) to the start node
+  static Nodevector<N> connected(const N& startnode);
+  /// renumber the nodes, node k becomes the node that had index order[k] (links, weights and tags follow)
+  void permute(const std::vector<Index>& order);
+  /// the same, also giving the old position of each link in the child and parent arrays (see EdgeColumn::permute)
+  void permute(const std::vector<Index>& order, std::vector<Index>& childSlots, std::vector<Index>& parentSlots);
+
+  std::size_t size() const { return m_nodes.size(); }
+  std::size_t edges() const { return m_children.size(); }
+  const N* node(Index i) const { return m_nodes[i]; }
+  const Nodevector<N>& nodes() const { return m_nodes; }
+  /// index of a node, npos if the node is not in the graph
+  Index index(const N* node) const;
+  bool contains(const N* node) const { return m_index.find(node) != m_index.end(); }
+  Range children(Index i) const {
+    return Range(m_children.data() + m_childOffsets[i], m_children.data() + m_childOffsets[i + 1]);
+  }
+  Range parents(Index i) const {
+    return Range(m_parents.data() + m_parentOffsets[i], m_parents.data() + m_parentOffsets[i + 1]);
+  }
+  /// the children of node i are found at [childOffsets()[i], childOffsets()[i+1]) of the child arrays
+  const std::vector<Index>& childOffsets() const { return m_childOffsets; }
+  const std::vector<Index>& parentOffsets() const { return m_parentOffsets; }
+  /// call f(const CompactLink&) for each link of node i that is followed by the visit type
+  template <typename F>
+  void forEachLink(Index i, VisitType visittype, F f) const;
+
+  /// true if the links were given weights
+  bool weighted() const { return !m_weights.empty(); }
+  /// weights of the links to the children of node i, in the same order as children(i)
+  WeightRange childWeights(Index i) const {
+    const double* weights = m_weights.childColumn().data();
+    return WeightRange(weights + m_childOffsets[i], weights + m_childOffsets[i + 1]);
+  }
+  /// weights of the links from the parents of node i, in the same order as parents(i)
+  WeightRange parentWeights(Index i) const {
+    const double* weights = m_weights.parentColumn().data();
+    return WeightRange(weights + m_parentOffsets[i], weights + m_parentOffsets[i + 1]);
+  }
+  /// weight of a link (of layer 0 for a LayeredGraph, see EdgeColumn)
+  double weight(const CompactLink& link) const { return m_weights[link]; }
+
+  /// give each node a type tag, tag(const N*) is called once for each node and must return 0..63
+  template <typename F>
+  void setTags(F tag);
+  Tag tag(Index i) const { return m_tags[i]; }
+  bool hasTag(Index i, TagMask mask) const { return mask.contains(m_tags[i]); }
+  /// tag of each node, by index
+  const std::vector<Tag>& tags() const { return m_tags; }
+
+protected:
+  Nodevector<N> m_nodes;                       ///< node of each index
+  std::unordered_map<const N*, Index> m_index;  ///< index of each node
+  std::vector<Index> m_childOffsets;           ///< start of the children of each node (plus the end)
+  std::vector<Index> m_children;               ///< child indices of all the nodes
+  std::vector<Index> m_parentOffsets;          ///< start of the parents of each node (plus the end)
+  std::vector<Index> m_parents;                ///< parent indices of all the nodes
+  EdgeColumn<double> m_weights;                ///< link weights (empty if none were given)
+  std::vector<Tag> m_tags;                     ///< type tag of each node
+};
+
+template <typename N>
+const typename CompactGraph<N>::Index CompactGraph<N>::npos;
+
+/// Constructor
+template <typename N>
+CompactGraph<N>::CompactGraph() : m_childOffsets(1, 0), m_parentOffsets(1, 0) {}
+
+/// Constructor
+template <typename N>
+CompactGraph<N>::CompactGraph(const Nodevector<N>& nodes) {
+  build(nodes);
+}
+
+/// Constructor
+template <typename N>
+CompactGraph<N>::CompactGraph(const Nodevector<N>& nodes, const WeightFunction& weight) {
+  build(nodes, weight);
+}
+
+/**
+ copy the links between a set of nodes into the index arrays
+ @param const Nodevector<N>& nodes - the nodes, their position in this vector becomes their index
+ @return void
+ */
+template <typename N>
+void CompactGraph<N>::build(const Nodevector<N>& nodes) {
+  m_nodes = nodes;
+  m_index.clear();
+  m_index.reserve(nodes.size());
+  for (Index i = 0; i < nodes.size(); ++i)
+    m_index.emplace(nodes[i], i);
+
+  m_childOffsets.assign(1, 0);
+  m_parentOffsets.assign(1, 0);
+  m_children.clear();
+  m_parents.clear();
+  m_weights.clear();
+  m_tags.assign(nodes.size(), 0);
+  m_childOffsets.reserve(nodes.size() + 1);
+  m_parentOffsets.reserve(nodes.size() + 1);
+  for (auto node : nodes) {
+    for (auto child : node->children()) {
+      auto found = m_index.find(child);
+      if (found != m_index.end()) m_children.push_back(found->second);
+    }
+    m_childOffsets.push_back(m_children.size());
+    for (auto parent : node->parents()) {
+      auto found = m_index.find(parent);
+      if (found != m_index.end()) m_parents.push_back(found->second);
+    }
+    m_parentOffsets.push_back(m_parents.size());
+  }
+}
+
+/**
+ copy the links between a set of nodes into the index arrays, with a weight stored alongside each link
+ @param const Nodevector<N>& nodes - the nodes, their position in this vector becomes their index
+ @param const WeightFunction& weight - called twice for each link (parent, child), see EdgeColumn::build
+ @return void
+ */
+template <typename N>
+void CompactGraph<N>::build(const Nodevector<N>& nodes, const WeightFunction& weight) {
+  build(nodes);
+  m_weights.build(*this, weight);
+}
+
+template <typename N>
+void CompactGraph<N>::permute(const std::vector<Index>& order) {
+  std::vector<Index> childSlots, parentSlots;
+  permute(order, childSlots, parentSlots);
+}
+
+/**
+ renumber the nodes, eg to put nodes that are searched together next to each other
+ NB EdgeColumns built for the graph must then be permuted with the slots (or rebuilt), NodeColumns with the order
+ @param const std::vector<Index>& order - old index of each new index (a permutation of 0..size()-1)
+ @param std::vector<Index>& childSlots - set to the old position of each link of the child array
+ @param std::vector<Index>& parentSlots - set to the old position of each link of the parent array
+ @return void
+ */
+template <typename N>
+void CompactGraph<N>::permute(const std::vector<Index>& order, std::vector<Index>& childSlots,
+                              std::vector<Index>& parentSlots) {
+  assert(order.size() == size() && "the order must renumber every node");
+  std::vector<Index> newIndex(order.size());
+  for (Index k = 0; k < order.size(); ++k)
+    newIndex[order[k]] = k;
+  Nodevector<N> nodes(m_nodes.get_allocator());
+  std::vector<Tag> tags;
+  nodes.reserve(order.size());
+  tags.reserve(order.size());
+  for (Index k = 0; k < order.size(); ++k) {
+    nodes.push_back(m_nodes[order[k]]);
+    tags.push_back(m_tags[order[k]]);
+    m_index[nodes.back()] = k;
+  }
+  m_nodes.swap(nodes);
+  m_tags.swap(tags);
+  permuteLinks(order, newIndex, m_childOffsets, m_children, childSlots);
+  permuteLinks(order, newIndex, m_parentOffsets, m_parents, parentSlots);
+  if (weighted()) m_weights.permute(childSlots, parentSlots);
+}
+
+template <typename N>
+template <typename F>
+void CompactGraph<N>::setTags(F tag) {
+  for (Index i = 0; i < m_nodes.size(); ++i) {
+    auto value = tag(m_nodes[i]);
+    assert(static_cast<unsigned long long>(value) < 64 && "node tags must be 0..63");  // negative ones too
+    m_tags[i] = Tag(value);
+  }
+}
+
+template <typename N>
+template <typename F>
+void CompactGraph<N>::forEachLink(Index i, VisitType visittype, F f) const {
+  if (visittype != VisitType::PARENTS)
+    for (Index slot = m_childOffsets[i]; slot < m_childOffsets[i + 1]; ++slot)
+      f(CompactLink{m_children[slot], slot, false, 0});
+  if (visittype != VisitType::CHILDREN)
+    for (Index slot = m_parentOffsets[i]; slot < m_parentOffsets[i + 1]; ++slot)
+      f(CompactLink{m_parents[slot], slot, true, 0});
+}
+
+/**
+ fill an attribute column from the nodes at each end of every link
+ @param const CompactGraph<N>& graph
+ @param F attribute - called as attribute(const N* parent, const N* child) for each link, once for its position in
+ the child array and once for its position in the parent array (so it should be cheap and give the same value)
+ @return void
+ */
+template <typename A>
+template <typename N, typename F>
+void EdgeColumn<A>::build(const CompactGraph<N>& graph, F attribute) {
+  m_child.clear();
+  m_parent.clear();
+  m_child.reserve(graph.edges());
+  m_parent.reserve(graph.edges());
+  for (unsigned int i = 0; i < graph.size(); ++i) {
+    for (auto child : graph.children(i))
+      m_child.push_back(attribute(graph.node(i), graph.node(child)));
+    for (auto parent : graph.parents(i))
+      m_parent.push_back(attribute(graph.node(parent), graph.node(i)));
+  }
+}
+
+template <typename A>
+void EdgeColumn<A>::permute(const std::vector<unsigned int>& childSlots,
+                            const std::vector<unsigned int>& parentSlots) {
+  std::vector<A> child, parent;
+  child.reserve(childSlots.size());
+  parent.reserve(parentSlots.size());
+  for (auto slot : childSlots)
+    child.push_back(m_child[slot]);
+  for (auto slot : parentSlots)
+    parent.push_back(m_parent[slot]);
+  m_child.swap(child);
+  m_parent.swap(parent);
+}
+
+template <typename A>
+void NodeColumn<A>::permute(const std::vector<unsigned int>& order) {
+  std::vector<A> values;
+  values.reserve(order.size());
+  for (auto old : order)
+    values.push_back(std::move(m_values[old]));
+  m_values.swap(values);
+}
+
+template <typename A>
+template <typename N, typename F>
+void NodeColumn<A>::build(const CompactGraph<N>& graph, F value) {
+  m_values.clear();
+  m_values.reserve(graph.size());
+  for (typename CompactGraph<N>::Index i = 0; i < graph.size(); ++i)
+    m_values.push_back(value(graph.node(i)));
+}
+
+template <typename N>
+Nodevector<N> CompactGraph<N>::connected(const N& startnode) {
+  BFSVisitor<N> bfs;
+  return bfs.traverseUndirected(startnode);
+}
+
+template <typename N>
+typename CompactGraph<N>::Index CompactGraph<N>::index(const N* node) const {
+  auto found = m_index.find(node);
+  return found == m_index.end() ? npos : found->second;
+}
+}
+
+#endif /* CompactGraph_h */
@@ -51,19 +51,43 @@
 #ifndef DAG_DirectedAcyclicGraph_h
 #define DAG_DirectedAcyclicGraph_h
 
+#include "PointerSet.h"
+#include "Prefetch.h"
+#include <functional>
 #include <iostream>
 #include <list>
+#include <memory>
 #include <queue>
+#include <type_traits>
 #include <unordered_set>
+#include <vector>
 
 /// DirectedAcyclicGraph Namespace
 namespace DAG {
 
+/// the allocator of a node type N (std::allocator unless N has an allocator_type)
+template <typename N, typename = void>
+struct NodeAllocator {
+  typedef std::allocator<void> type;
+};
+template <typename N>
+struct NodeAllocator<N, std::void_t<typename N::allocator_type>> {
+  typedef typename N::allocator_type type;
+};
+/// the allocator of the node type N for values of type V
+template <typename N, typename V>
+using NodeAllocatorFor = typename std::allocator_traits<typename NodeAllocator<N>::type>::template rebind_alloc<V>;
+
 // note internal use of pointer to N (supports the Nodes being concrete objects)
+// the containers use the allocator of the nodes, so they are std::unordered_set and std::vector for Node<T>
 template <typename N>
-using Nodeset = std::unordered_set<const N*>;  ///<allows find and just one of each node
+using Nodeset = std::unordered_set<const N*, std::hash<const N*>, std::equal_to<const N*>,
+                                   NodeAllocatorFor<N, const N*>>;  ///<allows find and just one of each node
 template <typename N>
-using Nodevector = std::vector<const N*>;  ///<typically used to return results
+using Nodevector = std::vector<const N*, NodeAllocatorFor<N, const N*>>;  ///<typically used to return results
+
+/// which links a traversal follows
+enum class VisitType { CHILDREN, PARENTS, UNDIRECTED };
 
 /// Visitor interface
 /**Defines the visitor class interface for the DirectedAcyclicGraph
@@ -86,11 +110,19 @@ protected:
 };
 
 /// Node class for visitor pattern templated on T the item of interest
-template <typename T>  // T is the item of interest inside the Node
+/// The links are stored using the Allocator (eg std::pmr::polymorphic_allocator, see PmrGraph.h)
+template <typename T, typename Allocator = std::allocator<void>>  // T is the item of interest inside the Node
 class Node {
 public:
-  typedef Node<T> TNode;
+  typedef Node<T, Allocator> TNode;
+  typedef T value_type;  ///< the item of interest
+  typedef Allocator allocator_type;
+  /// the set of links of a node (the same type as Nodeset<TNode>)
+  typedef std::unordered_set<const Node*, std::hash<const Node*>, std::equal_to<const Node*>,
+                             typename std::allocator_traits<Allocator>::template rebind_alloc<const Node*>>
+      Linkset;
   Node(const T& v);  ///< Constructor
+  Node(const T& v, const Allocator& allocator);  ///< Constructor with the allocator used for the links
   Node();            ///< Needed for putting a Node inside a unordered_set
   // ideally no copying because it means nodes are no longer unique
   TNode& operator=(TNode&) = delete;
@@ -101,41 +133,97 @@ public:
   // Move is good
   TNode& operator=(TNode&& other) = default;
   Node(TNode&& other) = default;
+  // allocator extended versions (used when nodes are put in containers that pass on their allocator)
+  Node(const TNode& other, const Allocator& allocator);
+  Node(TNode&& other, const Allocator& allocator);
 
   void accept(Visitor<TNode>& visitor) const;  ///< Key function for visitor pattern
   void addChild(Node& node);  ///< Add in a link (this will set the reverse parent link in the other node)
+  void removeChild(Node& node);  ///< Remove a link (this will also remove the reverse parent link in the other node)
+  void detach();                 ///< Remove all links to and from this node
   const T& value() const { return m_val; };  ///< return the node item
-  const Nodeset<TNode>& children() const { return m_children; }
-  const Nodeset<TNode>& parents() const { return m_parents; }
+  const Linkset& children() const { return m_children; }
+  const Linkset& parents() const { return m_parents; }
+  allocator_type get_allocator() const { return allocator_type(m_children.get_allocator()); }
 
 protected:
   T m_val;                                                 ///< thing that the node is encapsulating (eg identifier )
-  Nodeset<TNode> m_children;                               ///< direct child nodes
-  Nodeset<TNode> m_parents;                                ///< direct parent nodes
+  Linkset m_children;                                      ///< direct child nodes
+  Linkset m_parents;                                       ///< direct parent nodes
   void addParent(Node& node) { m_parents.insert(&node); }  // private as only available via addChild
+  void removeParent(const Node& node) { m_parents.erase(&node); }  // private as only available via removeChild
 };
 
-template <typename N>  /// Breadth First Search implementation of BFSVisitor (iterative)
-  class BFSVisitor : public Visitor<N> { ///N is the Node
+/// Breadth First Search implementation of BFSVisitor (iterative)
+/**
+ * After setReuseBuffers(true) the buffers are cleared rather than released, so repeating a traversal allocates
+ * no memory (NB the results vector is then overwritten by the next traversal). With several start nodes,
+ * setRecordSources(true) records the start node that reached each node first. setPrefetchDistance(d) loads
+ * the nodes d places ahead in the queue before they are expanded (see DAG_bench_prefetch).
+ * The same holds for BFSLevelVisitor and BFSTreeVisitor, which only prefetch within the level being expanded.
+ */
+template <typename N>
+class BFSVisitor : public Visitor<N> {  /// N is the Node
 public:
+  typedef typename NodeAllocator<N>::type allocator_type;
+
   BFSVisitor();
+  /// Constructor, the results and internal buffers use the allocator (eg that of the nodes)
+  explicit BFSVisitor(const allocator_type& allocator);
   void visit(const N* node) override;  ///< key to visitor pattern
   const Nodevector<N>& traverseChildren(const N& node, int depth = -1) override;
   const Nodevector<N>& traverseParents(const N& node, int depth = -1) override;
   const Nodevector<N>& traverseUndirected(const N& node, int depth = -1) override;
+  /// traversals from several start nodes
+  const Nodevector<N>& traverseChildren(const Nodevector<N>& startnodes, int depth = -1);
+  const Nodevector<N>& traverseParents(const Nodevector<N>& startnodes, int depth = -1);
+  const Nodevector<N>& traverseUndirected(const Nodevector<N>& startnodes, int depth = -1);
+  /// keep the buffers between traversals (see above)
+  void setReuseBuffers(bool reuse) { m_reuse = reuse; }
+  bool reuseBuffers() const { return m_reuse; }
+  /// record which start node reached each node (see above)
+  void setRecordSources(bool record) { m_recordSources = record; }
+  /// sources()[i] is the start node that reached results[i] first (empty unless sources are recorded)
+  const Nodevector<N>& sources() const { return m_sources; }
+  /// prefetch what the nodes this many places ahead in the queue will need (0 = no prefetching)
+  void setPrefetchDistance(unsigned distance) { m_prefetch = distance; }
+  unsigned prefetchDistance() const { return m_prefetch; }
 
 protected:
-  Nodeset<N> m_visited;    ///< which nodes have been visited (reset each time a traversal is made)
-  Nodevector<N> m_result;  ///< the list of nodes that are linked and that will be returned
-  enum class enumVisitType { CHILDREN, PARENTS, UNDIRECTED };  ///< internal enumeration
+  typedef PointerSet<const N*, NodeAllocatorFor<N, const N*>> Visited;
+  typedef std::vector<int, NodeAllocatorFor<N, int>> Depths;
+  Visited m_visited;        ///< which nodes have been visited (reset each time a traversal is made)
+  Nodevector<N> m_result;   ///< the list of nodes that are linked and that will be returned
+  Nodevector<N> m_start;    ///< the start node(s) given to the public traversals, in order
+  Nodeset<N> m_startSet;    ///< the same nodes, given to traverse
+  struct StartElement {  ///< an element taken out of m_startSet (wrapped so that it is not given an allocator)
+    typename Nodeset<N>::node_type element;
+  };
+  std::vector<StartElement, NodeAllocatorFor<N, StartElement>> m_spareStarts;  ///< kept for the next m_startSet
+  Nodevector<N> m_queue;    ///< queue of the iterative search (with a moving head)
+  Depths m_depthQueue;      ///< depth of each node in m_queue
+  Nodevector<N> m_sources;      ///< start node that reached each node of m_result
+  Nodevector<N> m_sourceQueue;  ///< start node that reached each node of m_queue
+  const N* m_source;            ///< start node that reached the node being expanded (nullptr for a start node)
+  bool m_reuse;
+  bool m_recordSources;
+  unsigned m_prefetch;  ///< prefetch distance in the queue (0 = off)
+  typedef VisitType enumVisitType;  ///< internal enumeration (kept for derived visitors)
 
   /// core traversal code uses by all of the public traversals
   virtual void traverse(const DAG::Nodeset<N>& nodes, BFSVisitor<N>::enumVisitType visittype,
                         int depth);  // the iterative method
-  bool alreadyVisited(const N* node) const;
+  /// the start nodes in the order given to the public traversals (in the order of the set for any other set)
+  const Nodevector<N>& startOrder(const Nodeset<N>& nodes);
+  bool alreadyVisited(const N* node) const { return m_visited.contains(node); }
+  /// start loading what the nodes of the queue after head will need when they are expanded
+  void prefetchAhead(const Nodevector<N>& queue, std::size_t head, VisitType visittype) const;
+  /// run one of the public traversals from the start node(s)
+  const Nodevector<N>& start(const Nodevector<N>& startnodes, VisitType visittype, int depth);
 };
 
 /// Breadth First Search alternative implementation using recursion
+/// (see BFSLevelVisitor for the same level by level search without recursion)
 template <typename N>
 class BFSRecurseVisitor : public BFSVisitor<N> {
 public:
@@ -143,31 +231,183 @@ private:
   /// core traversal code uses by all of the public traversals
   virtual void traverse(const DAG::Nodeset<N>& nodes, typename BFSVisitor<N>::enumVisitType visittype,
                         int depth) override;
+  /// one level of the recursion, sources[i] is the start node that reached nodes[i]
+  void traverseLevel(const Nodevector<N>& nodes, const Nodevector<N>& sources,
+                     typename BFSVisitor<N>::enumVisitType visittype, int depth);
+};
+
+/// Breadth First Search processing one level at a time (iterative)
+/**
+ * Gives the same levels as BFSRecurseVisitor, but uses two frontier buffers that are swapped at each level
+ * instead of recursing, so the stack use is bounded and no memory is allocated per level.
+ * The results are stored level by level and levelOffsets() gives where each level starts.
+ */
+template <typename N>
+class BFSLevelVisitor : public BFSVisitor<N> {
+public:
+  BFSLevelVisitor();
+  /// number of levels found by the last traversal (the start node(s) are level 0)
+  std::size_t levels() const { return m_levelOffsets.empty() ? 0 : m_levelOffsets.size() - 1; }
+  /// level k is found at [levelOffsets()[k], levelOffsets()[k+1]) in the results vector
+  const std::vector<std::size_t>& levelOffsets() const { return m_levelOffsets; }
+
+protected:
+  Nodevector<N> m_frontier;                 ///< nodes of the level being processed
+  Nodevector<N> m_next;                     ///< nodes of the next level
+  std::vector<std::size_t> m_levelOffsets;  ///< start of each level in m_result (plus the end)
+
+  /// core traversal code uses by all of the public traversals
+  virtual void traverse(const DAG::Nodeset<N>& nodes, typename BFSVisitor<N>::enumVisitType visittype,
+                        int depth) override;
+  /// called before the nodes reached from the node at this position of the results (-1 for the start nodes)
+  /// are visited, level is the level they are put in
+  virtual void expanding(long /*position*/, int /*level*/) {}
+};
+
+/// Breadth First Search that also returns the BFS tree
+/**
+ * For each node in the results, depths() gives its distance from the start node(s) and predecessors() gives
+ * the position (in the results) of the node through which it was reached, or -1 for a start node.
+ * These are parallel to the results vector and, together with levelOffsets(), give the nodes at a given
+ * distance or the path back to the start without traversing again.
+ */
+template <typename N>
+class BFSTreeVisitor : public BFSLevelVisitor<N> {
+public:
+  BFSTreeVisitor();
+  void visit(const N* node) override;  ///< key to visitor pattern
+  const std::vector<int>& depths() const { return m_depths; }
+  const std::vector<long>& predecessors() const { return m_predecessors; }
+  /// the nodes on the path from a start node to the node at position index of the results (empty if there is none)
+  Nodevector<N> path(std::size_t index) const;
+
+protected:
+  std::vector<int> m_depths;          ///< depth of each node in m_result
+  std::vector<long> m_predecessors;  ///< position in m_result of the BFS predecessor of each node
+  int m_level;                        ///< level of the nodes currently being visited
+  long m_predecessor;                 ///< position in m_result of the node being expanded (-1 for the start nodes)
+
+  /// core traversal code uses by all of the public traversals
+  virtual void traverse(const DAG::Nodeset<N>& nodes, typename BFSVisitor<N>::enumVisitType visittype,
+                        int depth) override;
+  void expanding(long position, int level) override {
+    m_predecessor = position;
+    m_level = level;
+  }
+};
+
+/// Depth First Search implementation using an explicit stack (no recursion)
+/**
+ * The visit order (pre-order) is returned by the traversals, the post-order (finish order) is available via
+ * postorder(). Optional callbacks are called when a node is first reached (pre-visit) and when all of its
+ * links have been followed (post-visit), both are given the node and its depth.
+ * NB the depth is measured along the path the search took, so a depth limit may leave out nodes that
+ * BFSVisitor would find through a shorter path.
+ * The stack and visited set are kept between traversals so their capacity is reused.
+ */
+template <typename N>
+class DFSVisitor : public Visitor<N> {
+public:
+  typedef std::function<void(const N*, int)> Callback;  ///< called with the node and its depth
+
+  DFSVisitor();
+  void visit(const N* node) override;  ///< key to visitor pattern
+  const Nodevector<N>& traverseChildren(const N& node, int depth = -1) override;
+  const Nodevector<N>& traverseParents(const N& node, int depth = -1) override;
+  const Nodevector<N>& traverseUndirected(const N& node, int depth = -1) override;
+  /// the nodes of the last traversal in the order in which they were finished
+  const Nodevector<N>& postorder() const { return m_postorder; }
+  void setPreVisit(Callback callback) { m_preVisit = callback; }
+  void setPostVisit(Callback callback) { m_postVisit = callback; }
+
+protected:
+  /// one entry of the explicit stack: a node and how far through its links we have got
+  struct Frame {
+    const N* node;
+    int depth;
+    bool parents;  ///< false while following children, true while following parents
+    typename Nodeset<N>::const_iterator next;
+  };
+  Nodeset<N> m_visited;       ///< which nodes have been visited (cleared each time a traversal is made)
+  Nodevector<N> m_result;     ///< nodes in pre-order
+  Nodevector<N> m_postorder;  ///< nodes in post-order
+  std::vector<Frame> m_stack;
+  Callback m_preVisit;
+  Callback m_postVisit;
+
+  /// core traversal code uses by all of the public traversals
+  virtual void traverse(const N& startnode, VisitType visittype, int depth);
+  void push(const N* node, int depth, VisitType visittype);
 };
 
 /// Constructor
-template <typename T>
-Node<T>::Node(const T& v) : m_val(v) {}
+template <typename T, typename Allocator>
+Node<T, Allocator>::Node(const T& v) : m_val(v) {}
 
 /// Constructor
-template <typename T>
-Node<T>::Node() : m_val(T()) {}
+template <typename T, typename Allocator>
+Node<T, Allocator>::Node(const T& v, const Allocator& allocator)
+    : m_val(v), m_children(typename Linkset::allocator_type(allocator)),
+      m_parents(typename Linkset::allocator_type(allocator)) {}
 
-template <typename T>
-void Node<T>::addChild(Node& node) {
+/// Constructor
+template <typename T, typename Allocator>
+Node<T, Allocator>::Node() : m_val(T()) {}
+
+/// Copy constructor using another allocator
+template <typename T, typename Allocator>
+Node<T, Allocator>::Node(const TNode& other, const Allocator& allocator)
+    : m_val(other.m_val), m_children(other.m_children, typename Linkset::allocator_type(allocator)),
+      m_parents(other.m_parents, typename Linkset::allocator_type(allocator)) {}
+
+/// Move constructor using another allocator
+template <typename T, typename Allocator>
+Node<T, Allocator>::Node(TNode&& other, const Allocator& allocator)
+    : m_val(std::move(other.m_val)),
+      m_children(std::move(other.m_children), typename Linkset::allocator_type(allocator)),
+      m_parents(std::move(other.m_parents), typename Linkset::allocator_type(allocator)) {}
+
+template <typename T, typename Allocator>
+void Node<T, Allocator>::addChild(Node& node) {
   // AddChild automatically adds in the parent link - this should be a safer route and avoid
   // missing links
   m_children.insert(&node);
   node.addParent(*this);
 }
 
+/**
+ remove the link between this node and a child node, both sides of the link are updated
+ @param Node& node - the child node (nothing happens if it is not a child of this node)
+ @return void
+ */
+template <typename T, typename Allocator>
+void Node<T, Allocator>::removeChild(Node& node) {
+  if (m_children.erase(&node) > 0) node.removeParent(*this);
+}
+
+/**
+ remove every link to and from this node, the node itself is left intact.
+ Cost is proportional to the number of links of this node.
+ @return void
+ */
+template <typename T, typename Allocator>
+void Node<T, Allocator>::detach() {
+  // the sets hold const pointers but the nodes themselves are never const (see class notes)
+  for (auto child : m_children)
+    const_cast<TNode*>(child)->removeParent(*this);
+  for (auto parent : m_parents)
+    const_cast<TNode*>(parent)->m_children.erase(this);
+  m_children.clear();
+  m_parents.clear();
+}
+
 /**
  accept the visitor
  @param Visitor<TNode>& visitor
  @return void
  */
-template <typename T>
-void Node<T>::accept(Visitor<TNode>& visitor) const {
+template <typename T, typename Allocator>
+void Node<T, Allocator>::accept(Visitor<TNode>& visitor) const {
   visitor.visit(this);
 };
 
@@ -177,7 +417,22 @@ Visitor<N>::Visitor() {}
 
 /// Constructor
 template <typename N>
-BFSVisitor<N>::BFSVisitor() : Visitor<N>(), m_visited() {}
+BFSVisitor<N>::BFSVisitor()
+    : Visitor<N>(), m_visited(), m_source(nullptr), m_reuse(false), m_recordSources(false), m_prefetch(0) {}
+
+/// Constructor
+template <typename N>
+BFSVisitor<N>::BFSVisitor(const allocator_type& allocator)
+    : Visitor<N>(), m_visited(typename Visited::allocator_type(allocator)),
+      m_result(typename Nodevector<N>::allocator_type(allocator)),
+      m_start(typename Nodevector<N>::allocator_type(allocator)),
+      m_startSet(typename Nodeset<N>::allocator_type(allocator)),
+      m_spareStarts(typename decltype(m_spareStarts)::allocator_type(allocator)),
+      m_queue(typename Nodevector<N>::allocator_type(allocator)),
+      m_depthQueue(typename Depths::allocator_type(allocator)),
+      m_sources(typename Nodevector<N>::allocator_type(allocator)),
+      m_sourceQueue(typename Nodevector<N>::allocator_type(allocator)), m_source(nullptr), m_reuse(false),
+      m_recordSources(false), m_prefetch(0) {}
 
 /**
  visit a node - add the node to the results and mark as "visited"
@@ -188,17 +443,32 @@ template <typename N>
 void BFSVisitor<N>::visit(const N* node) {
   m_result.push_back(node);  // add to result
   m_visited.insert(node);    // mark it as visited
+  if (m_recordSources) m_sources.push_back(m_source ? m_source : node);
 }
 
+/**
+ prefetch in two steps so that each load only uses addresses that the earlier step brought into the cache: the
+ node far ahead (its link sets), then the first link of a node half way. The rest of the links and their visited
+ marks are not prefetched, reaching them means walking the hash set, which costs as much as the expansion saves.
+ @param const Nodevector<N>& queue - the nodes waiting to be expanded
+ @param std::size_t head - position in the queue of the node about to be expanded
+ @param VisitType visittype - the links that are followed
+ @return void
+ */
 template <typename N>
-bool BFSVisitor<N>::alreadyVisited(const N* node) const {
-  if (m_visited.find(node) == m_visited.end()) return false;
-  return true;
+void BFSVisitor<N>::prefetchAhead(const Nodevector<N>& queue, std::size_t head, VisitType visittype) const {
+  if (head + m_prefetch < queue.size()) DAG::prefetch(queue[head + m_prefetch]);
+  std::size_t half = head + (m_prefetch + 1) / 2;
+  if (half < queue.size()) {
+    const N* node = queue[half];
+    if (visittype != VisitType::PARENTS && !node->children().empty()) DAG::prefetch(&*node->children().begin());
+    if (visittype != VisitType::CHILDREN && !node->parents().empty()) DAG::prefetch(&*node->parents().begin());
+  }
 }
 
 /**
  traverse the nodes using Breadth First Search implemented using a Queue
- @param Nodeset& nodes - the start node(s)
+ @param const Nodeset<N>& nodes - the start node(s)
  @param typename BFSVisitor<N>::enumVisitType visittype - CHILDREN/PARENTS/UNDIRECTED
  @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
  @return void
@@ -207,20 +477,24 @@ template <typename N>
 void BFSVisitor<N>::traverse(const Nodeset<N>& nodes, typename BFSVisitor<N>::enumVisitType visittype, int depth) {
   typedef typename BFSVisitor<N>::enumVisitType pt;
 
-  // Create a queue for the Breadth First Search
-  std::queue<const N*> nodeQueue;
-  std::queue<int> nodeDepth; //keeps track of the node depths so we can limit how deep we go if we wish
+  // The queue for the Breadth First Search is a vector with a moving head so that its memory can be kept
+  m_queue.clear();
+  m_depthQueue.clear();  // keeps track of the node depths so we can limit how deep we go if we wish
+  m_sourceQueue.clear();
+  std::size_t head = 0;
 
   // Mark the current node as visited and enqueue it
-  for (auto const& node : nodes) {
-    if (m_visited.find(node) == m_visited.end()) {  // if node is not listed as already being visited
-      node->accept(*this);                          // mark as visited and add to results
-      nodeQueue.push(node);                         // put into the queue
-      nodeDepth.push(0);
+  m_source = nullptr;
+  for (auto const& node : startOrder(nodes)) {
+    if (!alreadyVisited(node)) {  // if node is not listed as already being visited
+      node->accept(*this);        // mark as visited and add to results
+      m_queue.push_back(node);    // put into the queue
+      m_depthQueue.push_back(0);
+      if (m_recordSources) m_sourceQueue.push_back(node);
     }
   }
 
-  while (!nodeQueue.empty()) {
+  for (; head < m_queue.size(); ++head) {
 
     // Get head Node from Queue and iterate its children and/or parents
     // each of the parents and children that are not already visited
@@ -228,39 +502,42 @@ void BFSVisitor<N>::traverse(const Nodeset<N>& nodes, typename BFSVisitor<N>::en
     // One this is done the head Node can be removed (popped)
     // from the queue and processing proceeds to the
     // next item in the queue
-    int curdepth = nodeDepth.front();
+    if (m_prefetch) prefetchAhead(m_queue, head, visittype);
+    int curdepth = m_depthQueue[head];
+    const N* current = m_queue[head];
+    m_source = m_recordSources ? m_sourceQueue[head] : nullptr;  // what current reaches has the same source
 
     if ((depth < 0 || curdepth < depth) &&// NB depth=-1 means we are visiting everything
         ((visittype == pt::CHILDREN) | (visittype == pt::UNDIRECTED))) {  // use the children
-      for (auto node : nodeQueue.front()->children()) {
-        if (m_visited.find(node) == m_visited.end()) {  // check node is not already being visited
+      for (auto node : current->children()) {
+        if (!alreadyVisited(node)) {  // check node is not already being visited
           node->accept(*this);
 
-          nodeQueue.push(node);
-          nodeDepth.push(curdepth + 1);
+          m_queue.push_back(node);
+          m_depthQueue.push_back(curdepth + 1);
+          if (m_recordSources) m_sourceQueue.push_back(m_source);
         }
       }
     }
     if ((depth < 0 || curdepth < depth) && //NB depth=-1 means we are visiting everything
         ((visittype == pt::PARENTS) | (visittype == pt::UNDIRECTED))) {  // use the parents
-      for (auto node : nodeQueue.front()->parents()) {
+      for (auto node : current->parents()) {
 
-        if (m_visited.find(node) == m_visited.end()) {  // check node is not already being visited
+        if (!alreadyVisited(node)) {  // check node is not already being visited
           node->accept(*this);
 
-          nodeQueue.push(node);
-          nodeDepth.push(curdepth + 1);
+          m_queue.push_back(node);
+          m_depthQueue.push_back(curdepth + 1);
+          if (m_recordSources) m_sourceQueue.push_back(m_source);
         }
       }
     }
-    nodeQueue.pop();
-    nodeDepth.pop();
   }
 }
 
 /**
  traverse the nodes using Breadth First Search implemented using a recursion
- @param Nodeset<N>& nodes - the start node(s)
+ @param const Nodeset<N>& nodes - the start node(s)
  @param typename BFSVisitor<N>::enumVisitType visittype - CHILDREN/PARENTS/UNDIRECTED
  @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
  @return void
@@ -268,19 +545,37 @@ void BFSVisitor<N>::traverse(const Nodeset<N>& nodes, typename BFSVisitor<N>::en
 template <typename N>
 void BFSRecurseVisitor<N>::traverse(const Nodeset<N>& nodes, typename BFSVisitor<N>::enumVisitType visittype,
                                     int depth) {
+  const Nodevector<N>& starts = this->startOrder(nodes);
+  traverseLevel(starts, starts, visittype, depth);  // each start node is its own source
+}
+
+/**
+ one level of the recursive Breadth First Search
+ @param const Nodevector<N>& nodes - the nodes of this level (a node may appear twice)
+ @param const Nodevector<N>& sources - the start node that reached each of the nodes (only used if recorded)
+ @param typename BFSVisitor<N>::enumVisitType visittype - CHILDREN/PARENTS/UNDIRECTED
+ @param int depth - how many more levels to visit (-1 = everything)
+ @return void
+ */
+template <typename N>
+void BFSRecurseVisitor<N>::traverseLevel(const Nodevector<N>& nodes, const Nodevector<N>& sources,
+                                         typename BFSVisitor<N>::enumVisitType visittype, int depth) {
   // For a recursive  breadth first traversal we gather all nodes at the same depth
   typedef typename BFSVisitor<N>::enumVisitType pt;
-  Nodeset<N> visitnextnodes;  // this collects all the nodes at the next "depth"
+  Nodevector<N> visitnextnodes;  // this collects all the nodes at the next "depth" (a node may appear twice)
+  Nodevector<N> nextsources;     // the start node that reached each of visitnextnodes (if recorded)
 
   if (nodes.empty()) {
     return;  // end of the recursion
   }
 
-  for (auto node : nodes) {
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    const N* node = nodes[i];
 
     // Only process a node if not already visited
-    if (BFSVisitor<N>::m_visited.find(node) == BFSVisitor<N>::m_visited.end()) {
+    if (!this->alreadyVisited(node)) {
       // this will add the node to the "result" and mark the node as visited
+      this->m_source = this->m_recordSources ? sources[i] : nullptr;
       node->accept(*this);
 
       // Now add in all the children/parent/undirected links for the next depth
@@ -288,62 +583,347 @@ void BFSRecurseVisitor<N>::traverse(const Nodeset<N>& nodes, typename BFSVisitor
       // NB depth=-1 means we are visiting everything
       if (depth != 0 && (visittype == pt::CHILDREN | visittype == pt::UNDIRECTED))
         for (const auto child : node->children()) {
-          if (!this->alreadyVisited(child)) visitnextnodes.insert(child);
+          if (!this->alreadyVisited(child)) visitnextnodes.push_back(child);
         }
       if (depth != 0 && (visittype == pt::PARENTS | visittype == pt::UNDIRECTED))
         for (const auto parent : node->parents()) {
-          if (!this->alreadyVisited(parent)) visitnextnodes.insert(parent);
+          if (!this->alreadyVisited(parent)) visitnextnodes.push_back(parent);
         }
+      if (this->m_recordSources) nextsources.resize(visitnextnodes.size(), sources[i]);
     }
   }
   depth--;
-  traverse(visitnextnodes, visittype, depth);
+  traverseLevel(visitnextnodes, nextsources, visittype, depth);
+}
+
+/// Constructor
+template <typename N>
+BFSLevelVisitor<N>::BFSLevelVisitor() : BFSVisitor<N>() {}
+
+/**
+ traverse the nodes using Breadth First Search one level at a time
+ @param const Nodeset<N>& nodes - the start node(s)
+ @param typename BFSVisitor<N>::enumVisitType visittype - CHILDREN/PARENTS/UNDIRECTED
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return void
+ */
+template <typename N>
+void BFSLevelVisitor<N>::traverse(const Nodeset<N>& nodes, typename BFSVisitor<N>::enumVisitType visittype,
+                                  int depth) {
+  typedef typename BFSVisitor<N>::enumVisitType pt;
+  m_frontier.clear();
+  m_next.clear();
+  m_levelOffsets.clear();
+
+  m_levelOffsets.push_back(this->m_result.size());
+  expanding(-1, 0);
+  this->m_source = nullptr;
+  for (auto node : this->startOrder(nodes)) {
+    if (!this->alreadyVisited(node)) {
+      node->accept(*this);  // mark as visited and add to results
+      m_frontier.push_back(node);
+    }
+  }
+
+  // NB depth=-1 means we are visiting everything
+  for (int level = 0; !m_frontier.empty(); ++level) {
+    m_levelOffsets.push_back(this->m_result.size());
+    if (level == depth) break;
+    for (std::size_t i = 0; i < m_frontier.size(); ++i) {
+      if (this->m_prefetch) this->prefetchAhead(m_frontier, i, visittype);  // only within the level
+      const N* node = m_frontier[i];
+      std::size_t position = m_levelOffsets[level] + i;  // the frontier is the same as this level of the results
+      expanding(position, level + 1);
+      this->m_source = this->m_recordSources ? this->m_sources[position] : nullptr;
+      // nodes are marked as visited as soon as they are found so each one only enters one level
+      if (visittype == pt::CHILDREN || visittype == pt::UNDIRECTED)
+        for (auto child : node->children()) {
+          if (!this->alreadyVisited(child)) {
+            child->accept(*this);
+            m_next.push_back(child);
+          }
+        }
+      if (visittype == pt::PARENTS || visittype == pt::UNDIRECTED)
+        for (auto parent : node->parents()) {
+          if (!this->alreadyVisited(parent)) {
+            parent->accept(*this);
+            m_next.push_back(parent);
+          }
+        }
+    }
+    m_frontier.swap(m_next);  // the next level becomes the current one, keeping both buffers
+    m_next.clear();
+  }
+}
+
+/// Constructor
+template <typename N>
+BFSTreeVisitor<N>::BFSTreeVisitor() : BFSLevelVisitor<N>(), m_level(0), m_predecessor(-1) {}
+
+/**
+ visit a node - add the node, its depth and its predecessor to the results and mark as "visited"
+ @param N* node - the node that is to be visited
+ @return void
+ */
+template <typename N>
+void BFSTreeVisitor<N>::visit(const N* node) {
+  BFSVisitor<N>::visit(node);
+  m_depths.push_back(m_level);
+  m_predecessors.push_back(m_predecessor);
+}
+
+template <typename N>
+void BFSTreeVisitor<N>::traverse(const Nodeset<N>& nodes, typename BFSVisitor<N>::enumVisitType visittype,
+                                 int depth) {
+  m_depths.clear();
+  m_predecessors.clear();
+  BFSLevelVisitor<N>::traverse(nodes, visittype, depth);
+}
+
+/**
+ follow the predecessors back from a node to the start node
+ @param std::size_t index - position of the node in the results vector
+ @return Nodevector<N> - the path, starting with the start node and ending with the requested node, empty if
+ index is not a position of the last traversal
+ */
+template <typename N>
+Nodevector<N> BFSTreeVisitor<N>::path(std::size_t index) const {
+  if (index >= m_depths.size()) return Nodevector<N>();
+  Nodevector<N> result(m_depths[index] + 1);
+  for (long i = index; i >= 0; i = m_predecessors[i])
+    result[m_depths[i]] = this->m_result[i];
+  return result;
 }
 
 /**
  traverse the children using Breadth First Search
  @param N& startnode
  @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
- @return const std::vector<N*>&  results vector of Nodes
+ @return const Nodevector<N>&  results vector of Nodes
  */
 template <typename N>
-const std::vector<const N*>& BFSVisitor<N>::traverseChildren(const N& startnode, int depth) {
-  m_result = {};                // reset the list of results:
-  Nodeset<N> root{&startnode};  // create an initial nodeset containing the root node
-  traverse(root, BFSVisitor<N>::enumVisitType::CHILDREN, depth);
-  m_visited = {};  // reset the list of visited nodes
-  return m_result;
+const Nodevector<N>& BFSVisitor<N>::traverseChildren(const N& startnode, int depth) {
+  m_start.assign(1, &startnode);
+  return start(m_start, BFSVisitor<N>::enumVisitType::CHILDREN, depth);
+}
+
+/**
+ traverse the children of several start nodes using Breadth First Search (each node is visited once)
+ @param const Nodevector<N>& startnodes
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return const Nodevector<N>&  results vector of Nodes
+ */
+template <typename N>
+const Nodevector<N>& BFSVisitor<N>::traverseChildren(const Nodevector<N>& startnodes, int depth) {
+  return start(startnodes, BFSVisitor<N>::enumVisitType::CHILDREN, depth);
 }
 
 /**
  traverse the parents using Breadth First Search
  @param N& startnode
  @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
- @return const std::vector<N*>&  results vector of Nodes
+ @return const Nodevector<N>&  results vector of Nodes
  */
 template <typename N>
-const std::vector<const N*>& BFSVisitor<N>::traverseParents(const N& startnode, int depth) {
-  m_result = {};                // reset the list of results
-  Nodeset<N> root{&startnode};  // create an initial nodeset containing the root node
-  traverse(root, BFSVisitor<N>::enumVisitType::PARENTS, depth);
-  m_visited = {};  // reset the list of visited nodes
-  return m_result;
+const Nodevector<N>& BFSVisitor<N>::traverseParents(const N& startnode, int depth) {
+  m_start.assign(1, &startnode);
+  return start(m_start, BFSVisitor<N>::enumVisitType::PARENTS, depth);
+}
+
+/**
+ traverse the parents of several start nodes using Breadth First Search (each node is visited once)
+ @param const Nodevector<N>& startnodes
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return const Nodevector<N>&  results vector of Nodes
+ */
+template <typename N>
+const Nodevector<N>& BFSVisitor<N>::traverseParents(const Nodevector<N>& startnodes, int depth) {
+  return start(startnodes, BFSVisitor<N>::enumVisitType::PARENTS, depth);
 }
 
 /**
  traverse all nodes linked to the start node using Breadth First Search
  @param N& startnode
  @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
- @return const std::vector<N*>&  results vector of Nodes
+ @return const Nodevector<N>&  results vector of Nodes
+ */
+template <typename N>
+const Nodevector<N>& BFSVisitor<N>::traverseUndirected(const N& startnode, int depth) {
+  m_start.assign(1, &startnode);
+  return start(m_start, BFSVisitor<N>::enumVisitType::UNDIRECTED, depth);
+}
+
+/**
+ traverse all nodes linked to the start nodes of several start nodes using Breadth First Search (each node is visited once)
+ @param const Nodevector<N>& startnodes
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return const Nodevector<N>&  results vector of Nodes
+ */
+template <typename N>
+const Nodevector<N>& BFSVisitor<N>::traverseUndirected(const Nodevector<N>& startnodes, int depth) {
+  return start(startnodes, BFSVisitor<N>::enumVisitType::UNDIRECTED, depth);
+}
+
+/**
+ reset the results, traverse from the start nodes and reset the visited nodes
+ @param const Nodevector<N>& startnodes
+ @param VisitType visittype - CHILDREN/PARENTS/UNDIRECTED
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return const Nodevector<N>&  results vector of Nodes
+ */
+template <typename N>
+const Nodevector<N>& BFSVisitor<N>::start(const Nodevector<N>& startnodes, VisitType visittype, int depth) {
+  if (&startnodes != &m_start) m_start.assign(startnodes.begin(), startnodes.end());
+  // the set given to traverse is refilled with the elements of the previous one, so that it does not allocate
+  while (!m_startSet.empty())
+    m_spareStarts.push_back(StartElement{m_startSet.extract(m_startSet.begin())});
+  for (auto node : m_start) {
+    if (m_spareStarts.empty()) {
+      m_startSet.insert(node);
+      continue;
+    }
+    m_spareStarts.back().element.value() = node;
+    auto inserted = m_startSet.insert(std::move(m_spareStarts.back().element));
+    m_spareStarts.pop_back();
+    if (!inserted.inserted) m_spareStarts.push_back(StartElement{std::move(inserted.node)});  // given twice
+  }
+  if (m_reuse) m_spareStarts.reserve(m_startSet.size());  // room to take the elements out at the next traversal
+  if (m_reuse) {
+    m_result.clear();  // keep the capacity for the next traversal
+    m_sources.clear();
+    traverse(m_startSet, visittype, depth);
+    m_visited.clear();
+  } else {
+    // the memory is released by moving in empty containers with the same allocators
+    m_result = Nodevector<N>(m_result.get_allocator());  // reset the list of results
+    m_sources = Nodevector<N>(m_sources.get_allocator());
+    traverse(m_startSet, visittype, depth);
+    m_visited = Visited(m_visited.get_allocator());  // reset the list of visited nodes
+    m_start = Nodevector<N>(m_start.get_allocator());
+    m_startSet = Nodeset<N>(m_startSet.get_allocator());
+    m_spareStarts = decltype(m_spareStarts)(m_spareStarts.get_allocator());
+    m_queue = Nodevector<N>(m_queue.get_allocator());
+    m_depthQueue = Depths(m_depthQueue.get_allocator());
+    m_sourceQueue = Nodevector<N>(m_sourceQueue.get_allocator());
+  }
+  return m_result;
+}
+
+/**
+ the start nodes of a traversal in order: the set built by start() stands for m_start, any other set is taken
+ in the order of its elements
+ @param const Nodeset<N>& nodes - the start node(s) given to traverse
+ @return const Nodevector<N>& - the same nodes
+ */
+template <typename N>
+const Nodevector<N>& BFSVisitor<N>::startOrder(const Nodeset<N>& nodes) {
+  if (&nodes != &m_startSet) m_start.assign(nodes.begin(), nodes.end());
+  return m_start;
+}
+
+/// Constructor
+template <typename N>
+DFSVisitor<N>::DFSVisitor() : Visitor<N>() {}
+
+/**
+ visit a node - add the node to the results and mark as "visited"
+ @param N* node - the node that is to be visited
+ @return void
+ */
+template <typename N>
+void DFSVisitor<N>::visit(const N* node) {
+  m_result.push_back(node);
+  m_visited.insert(node);
+}
+
+/// visit a node and put it on the stack
+template <typename N>
+void DFSVisitor<N>::push(const N* node, int depth, VisitType visittype) {
+  node->accept(*this);
+  if (m_preVisit) m_preVisit(node, depth);
+  if (visittype == VisitType::PARENTS)
+    m_stack.push_back(Frame{node, depth, true, node->parents().begin()});
+  else
+    m_stack.push_back(Frame{node, depth, false, node->children().begin()});
+}
+
+/**
+ traverse the nodes using Depth First Search implemented using an explicit stack
+ @param N& startnode
+ @param VisitType visittype - CHILDREN/PARENTS/UNDIRECTED
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node, 2= start node plus 2 levels)
+ @return void
+ */
+template <typename N>
+void DFSVisitor<N>::traverse(const N& startnode, VisitType visittype, int depth) {
+  m_result.clear();  // clear rather than reset so that the capacity is kept
+  m_postorder.clear();
+  m_visited.clear();
+  m_stack.clear();
+
+  push(&startnode, 0, visittype);
+  while (!m_stack.empty()) {
+    Frame& frame = m_stack.back();
+    const N* next = nullptr;
+    if (depth < 0 || frame.depth < depth) {  // NB depth=-1 means we are visiting everything
+      // find the next link of this node that has not yet been visited
+      while (next == nullptr) {
+        const Nodeset<N>& links = frame.parents ? frame.node->parents() : frame.node->children();
+        if (frame.next == links.end()) {
+          if (frame.parents || visittype != VisitType::UNDIRECTED) break;
+          frame.parents = true;  // children are done, now the parents
+          frame.next = frame.node->parents().begin();
+          continue;
+        }
+        const N* candidate = *frame.next++;
+        if (m_visited.find(candidate) == m_visited.end()) next = candidate;
+      }
+    }
+    if (next != nullptr) {
+      push(next, frame.depth + 1, visittype);  // NB frame is invalid after this
+    } else {
+      if (m_postVisit) m_postVisit(frame.node, frame.depth);
+      m_postorder.push_back(frame.node);
+      m_stack.pop_back();
+    }
+  }
+}
+
+/**
+ traverse the children using Depth First Search
+ @param N& startnode
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return const Nodevector<N>&  results vector of Nodes in pre-order
+ */
+template <typename N>
+const Nodevector<N>& DFSVisitor<N>::traverseChildren(const N& startnode, int depth) {
+  traverse(startnode, VisitType::CHILDREN, depth);
+  return m_result;
+}
+
+/**
+ traverse the parents using Depth First Search
+ @param N& startnode
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return const Nodevector<N>&  results vector of Nodes in pre-order
+ */
+template <typename N>
+const Nodevector<N>& DFSVisitor<N>::traverseParents(const N& startnode, int depth) {
+  traverse(startnode, VisitType::PARENTS, depth);
+  return m_result;
+}
+
+/**
+ traverse all nodes linked to the start node using Depth First Search
+ @param N& startnode
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return const Nodevector<N>&  results vector of Nodes in pre-order
  */
 template <typename N>
-const std::vector<const N*>& BFSVisitor<N>::traverseUndirected(const N& startnode, int depth) {
-  m_result = {};                // reset the list of results
-  Nodeset<N> root{&startnode};  // create an initial nodeset containing the root node
-  traverse(root, BFSVisitor<N>::enumVisitType::UNDIRECTED, depth);
-  m_visited = {};  // reset the list of visited nodes
+const Nodevector<N>& DFSVisitor<N>::traverseUndirected(const N& startnode, int depth) {
+  traverse(startnode, VisitType::UNDIRECTED, depth);
   return m_result;
 }
 }
 
-#endif /* DirectedAcyclicGraph */
\ No newline at end of file
+#endif /* DirectedAcyclicGraph */
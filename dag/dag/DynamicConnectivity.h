@@ -0,0 +1,216 @@
+#ifndef DAG_DYNAMICCONNECTIVITY_H
+#define DAG_DYNAMICCONNECTIVITY_H
+/** @class   DAG::DynamicConnectivity
+ *
+ *  @brief DynamicConnectivity keeps track of the blocks of connected nodes while links are added and removed
+ *
+ *   The blocks are the same as those returned by FloodFill, but they are maintained incrementally:
+ *    - adding a link merges two blocks (the smaller block is relabelled)
+ *    - removing a link runs two interleaved undirected searches, one from each end of the removed link.
+ *      If the searches meet the block is still connected. Otherwise the search that finishes first has
+ *      found the smaller of the two pieces and only those nodes are moved into a new block.
+ *   So the cost of a removal is proportional to the smaller piece and never to the whole graph.
+ *
+ *  Only nodes that have been added to the DynamicConnectivity are tracked, links to other nodes are ignored.
+ *
+ *  Example usage:
+ *
+ typedef DAG::Node<int> INode;
+ INode n0(0), n1(1), n2(2);
+ DAG::DynamicConnectivity<INode> blocks;
+ blocks.addNode(n0);
+ blocks.addNode(n1);
+ blocks.addNode(n2);
+ blocks.addChild(n0, n1);
+ blocks.addChild(n1, n2);    // one block {0,1,2}
+ blocks.removeChild(n0, n1); // two blocks {0} and {1,2}
+ *
+ */
+
+#include "DirectedAcyclicGraph.h"
+#include <unordered_map>
+#include <vector>
+
+namespace DAG {
+/// DynamicConnectivity maintains blocks of connected nodes under link insertion and removal
+template <typename N>  /// N is the Node
+class DynamicConnectivity {
+public:
+  typedef int BlockId;
+
+  DynamicConnectivity();
+  /// Start tracking a node, it is merged with the blocks of any tracked nodes it is already linked to
+  void addNode(N& node);
+  /// Stop tracking a node, all its links are removed and its block is split if needed
+  void removeNode(N& node);
+  /// Add a link between two tracked nodes, merging their blocks
+  void addChild(N& parent, N& child);
+  /// Remove a link between two tracked nodes, returns true if this split the block in two
+  bool removeChild(N& parent, N& child);
+
+  bool contains(const N& node) const { return m_blockOf.find(&node) != m_blockOf.end(); }
+  /// the block identifier of a tracked node
+  BlockId block(const N& node) const { return m_blockOf.at(&node); }
+  /// the nodes that make up a block
+  const Nodeset<N>& blockNodes(BlockId id) const { return m_blocks.at(id); }
+  /// number of blocks
+  std::size_t blocks() const { return m_blocks.size(); }
+  /// Return a vector that itself contains vectors of connected nodes (same layout as FloodFill)
+  std::vector<Nodevector<N>> blockVectors() const;
+
+private:
+  std::unordered_map<const N*, BlockId> m_blockOf;  ///< block of each tracked node
+  std::unordered_map<BlockId, Nodeset<N>> m_blocks;  ///< nodes contained in each block
+  BlockId m_nextId;                                  ///< next unused block identifier
+  // search buffers, kept between calls so that their capacity is reused
+  Nodeset<N> m_seen[2];
+  Nodevector<N> m_queue[2];
+
+  void merge(BlockId a, BlockId b);
+  bool split(const N* a, const N* b);
+  bool expand(int side, std::size_t& head);
+};
+
+template <typename N>
+DynamicConnectivity<N>::DynamicConnectivity() : m_nextId(0) {}
+
+template <typename N>
+void DynamicConnectivity<N>::addNode(N& node) {
+  if (contains(node)) return;
+  BlockId id = m_nextId++;
+  m_blockOf[&node] = id;
+  m_blocks[id].insert(&node);
+  for (auto child : node.children())
+    if (m_blockOf.find(child) != m_blockOf.end()) merge(m_blockOf[&node], m_blockOf[child]);
+  for (auto parent : node.parents())
+    if (m_blockOf.find(parent) != m_blockOf.end()) merge(m_blockOf[&node], m_blockOf[parent]);
+}
+
+/**
+ remove a node, its links are removed one at a time so that each split only touches the affected piece
+ @param N& node - a tracked node
+ @return void
+ */
+template <typename N>
+void DynamicConnectivity<N>::removeNode(N& node) {
+  if (!contains(node)) return;
+  Nodevector<N> children(node.children().begin(), node.children().end());
+  Nodevector<N> parents(node.parents().begin(), node.parents().end());
+  // the node sets hold const pointers but the nodes themselves are never const
+  for (auto child : children)
+    removeChild(node, *const_cast<N*>(child));
+  for (auto parent : parents)
+    removeChild(*const_cast<N*>(parent), node);
+  node.detach();  // drops any links to untracked nodes
+  BlockId id = m_blockOf[&node];
+  m_blockOf.erase(&node);
+  m_blocks.erase(id);  // the node is now alone in its block
+}
+
+template <typename N>
+void DynamicConnectivity<N>::addChild(N& parent, N& child) {
+  parent.addChild(child);
+  if (contains(parent) && contains(child)) merge(m_blockOf[&parent], m_blockOf[&child]);
+}
+
+/**
+ remove a link and split the block if the two nodes are no longer connected
+ @param N& parent
+ @param N& child
+ @return bool - true if the block was split
+ */
+template <typename N>
+bool DynamicConnectivity<N>::removeChild(N& parent, N& child) {
+  if (parent.children().find(&child) == parent.children().end()) return false;
+  parent.removeChild(child);
+  if (!contains(parent) || !contains(child)) return false;
+  // another link may still join the two nodes directly (eg child also being a parent)
+  if (parent.parents().find(&child) != parent.parents().end()) return false;
+  return split(&parent, &child);
+}
+
+template <typename N>
+std::vector<Nodevector<N>> DynamicConnectivity<N>::blockVectors() const {
+  std::vector<Nodevector<N>> result;
+  result.reserve(m_blocks.size());
+  for (const auto& block : m_blocks)
+    result.emplace_back(block.second.begin(), block.second.end());
+  return result;
+}
+
+/// move all the nodes of the smaller block into the larger one
+template <typename N>
+void DynamicConnectivity<N>::merge(BlockId a, BlockId b) {
+  if (a == b) return;
+  if (m_blocks[a].size() < m_blocks[b].size()) std::swap(a, b);
+  Nodeset<N>& target = m_blocks[a];
+  for (auto node : m_blocks[b]) {
+    m_blockOf[node] = a;
+    target.insert(node);
+  }
+  m_blocks.erase(b);
+}
+
+/**
+ expand the next node of one of the two searches
+ @param int side - which search (0 or 1)
+ @param std::size_t& head - position of the next node to expand in the search queue
+ @return bool - true if the two searches have met
+ */
+template <typename N>
+bool DynamicConnectivity<N>::expand(int side, std::size_t& head) {
+  const N* node = m_queue[side][head++];
+  for (const Nodeset<N>* links : {&node->children(), &node->parents()}) {
+    for (auto next : *links) {
+      if (m_blockOf.find(next) == m_blockOf.end()) continue;  // not tracked
+      if (m_seen[1 - side].find(next) != m_seen[1 - side].end()) return true;
+      if (m_seen[side].insert(next).second) m_queue[side].push_back(next);
+    }
+  }
+  return false;
+}
+
+/**
+ interleaved search from both ends of a removed link, the smaller piece (if any) gets a new block
+ @param const N* a
+ @param const N* b
+ @return bool - true if the block was split
+ */
+template <typename N>
+bool DynamicConnectivity<N>::split(const N* a, const N* b) {
+  for (int side = 0; side < 2; ++side) {
+    m_seen[side].clear();
+    m_queue[side].clear();
+  }
+  m_seen[0].insert(a);
+  m_queue[0].push_back(a);
+  m_seen[1].insert(b);
+  m_queue[1].push_back(b);
+
+  std::size_t head[2] = {0, 0};
+  int finished = -1;  // which search ran out of nodes first
+  while (finished < 0) {
+    for (int side = 0; side < 2; ++side) {
+      if (head[side] == m_queue[side].size()) {
+        finished = side;
+        break;
+      }
+      if (expand(side, head[side])) return false;  // still connected
+    }
+  }
+
+  // the finished search holds the complete (smaller) piece
+  BlockId oldId = m_blockOf[a];
+  BlockId newId = m_nextId++;
+  Nodeset<N>& oldBlock = m_blocks[oldId];
+  Nodeset<N>& newBlock = m_blocks[newId];
+  for (auto node : m_queue[finished]) {
+    oldBlock.erase(node);
+    newBlock.insert(node);
+    m_blockOf[node] = newId;
+  }
+  return true;
+}
+}
+
+#endif /* DynamicConnectivity_h */
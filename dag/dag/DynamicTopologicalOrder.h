@@ -0,0 +1,290 @@
+#ifndef DAG_DYNAMICTOPOLOGICALORDER_H
+#define DAG_DYNAMICTOPOLOGICALORDER_H
+/** @class   DAG::DynamicTopologicalOrder
+ *
+ *  @brief DynamicTopologicalOrder adds links between nodes while guaranteeing that the graph stays acyclic
+ *
+ *   Node::addChild accepts any link. Links added via DynamicTopologicalOrder::addChild are checked first and
+ *   a link that would create a cycle is refused (addChild returns false and the nodes are unchanged).
+ *
+ *   A topological order of the nodes is maintained as links are added (Pearce-Kelly algorithm). A new link
+ *   parent -> child that already agrees with the order costs O(1). Otherwise only the nodes whose order lies
+ *   between the child and the parent are searched: forward from the child (a cycle if the parent is found)
+ *   and backward from the parent, and the nodes found are given new positions among the ones they already
+ *   occupied. So the cost depends on the affected region, not on the size of the graph.
+ *
+ *   A node that already has links when it starts being tracked (addNode, or addChild on an untracked node) brings
+ *   the untracked nodes linked to it through untracked nodes into the order. They are put at the end in the order
+ *   of their own links, and each of their links to a tracked node is then added as above, so the cost depends on
+ *   these nodes and the region affected by their links. If the existing links contain a cycle, the nodes are not
+ *   tracked and addNode/addChild return false. Links between tracked nodes must be made through addChild, links
+ *   made directly with Node::addChild are not checked.
+ *
+ *  Example usage:
+ *
+ typedef DAG::Node<int> INode;
+ INode n0(0), n1(1);
+ DAG::DynamicTopologicalOrder<INode> dag;
+ dag.addChild(n0, n1);                  // true
+ bool linked = dag.addChild(n1, n0);   // false, this would be a cycle
+ *
+ */
+
+#include "DirectedAcyclicGraph.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace DAG {
+/// DynamicTopologicalOrder refuses links that would create a cycle
+template <typename N>  /// N is the Node
+class DynamicTopologicalOrder {
+public:
+  DynamicTopologicalOrder();
+  /// Start tracking a node and the untracked nodes linked to it (nodes are also added automatically by addChild).
+  /// Returns false (and tracks nothing) if their existing links contain a cycle.
+  bool addNode(const N& node);
+  /// Add a link unless it would create a cycle, returns true if the link was added
+  bool addChild(N& parent, N& child);
+  /// Remove a link (the order stays valid)
+  void removeChild(N& parent, N& child) { parent.removeChild(child); }
+  /// Remove all the links of a node and stop tracking it
+  void removeNode(N& node);
+  bool contains(const N& node) const { return m_order.find(&node) != m_order.end(); }
+  /// position of a node in the topological order (only the relative values are meaningful)
+  long position(const N& node) const { return m_order.at(&node); }
+  /// true if a link parent -> child could be added without making a cycle
+  bool canAddChild(const N& parent, const N& child);
+
+private:
+  std::unordered_map<const N*, long> m_order;  ///< position of each node in the topological order
+  long m_next;                                 ///< position given to the next new node
+  // search buffers, kept between calls so that their capacity is reused
+  Nodeset<N> m_visited;
+  Nodevector<N> m_stack;
+  Nodevector<N> m_forward;
+  Nodevector<N> m_backward;
+  std::vector<long> m_positions;
+  std::unordered_map<const N*, long> m_incoming;  ///< untracked nodes being tracked, number of untracked parents
+  Nodevector<N> m_component;                      ///< the same nodes, in the order they were found
+  Nodevector<N> m_sorted;                         ///< the same nodes, in the order of their links
+  Nodevector<N> m_added;                          ///< nodes tracked by the current call, untracked if it fails
+
+  bool track(const N& node);
+  void untrack();
+  bool follow(const N* parent, const N* child);
+  bool searchForward(const N* child, const N* parent, long upper);
+  bool reaches(const N* from, const N* to);
+  void searchBackward(const N* parent, long lower);
+  void reorder();
+};
+
+/// Constructor
+template <typename N>
+DynamicTopologicalOrder<N>::DynamicTopologicalOrder() : m_next(0) {}
+
+/**
+ start tracking a node, a node without links goes to the end of the order
+ @param const N& node
+ @return bool - false if the node is linked to a cycle (nothing is changed)
+ */
+template <typename N>
+bool DynamicTopologicalOrder<N>::addNode(const N& node) {
+  m_added.clear();
+  if (track(node)) return true;
+  untrack();
+  return false;
+}
+
+/**
+ track a node and the untracked nodes linked to it through untracked nodes: they are put at the end of the order
+ one by one in the order of their links (Kahn), then their links to the nodes already ordered are followed
+ @param const N& node
+ @return bool - false if there is a cycle, the nodes tracked so far are in m_added
+ */
+template <typename N>
+bool DynamicTopologicalOrder<N>::track(const N& node) {
+  if (contains(node)) return true;
+  m_incoming.clear();
+  m_component.assign(1, &node);
+  m_incoming.emplace(&node, 0);
+  for (std::size_t k = 0; k < m_component.size(); ++k) {
+    const N* current = m_component[k];
+    for (auto links : {&current->children(), &current->parents()})
+      for (auto next : *links)
+        if (!contains(*next) && m_incoming.emplace(next, 0).second) m_component.push_back(next);
+  }
+  for (auto current : m_component)
+    for (auto child : current->children()) {
+      auto found = m_incoming.find(child);
+      if (found != m_incoming.end()) ++found->second;
+    }
+  m_sorted.clear();
+  m_stack.clear();
+  for (auto current : m_component)
+    if (m_incoming[current] == 0) m_stack.push_back(current);
+  while (!m_stack.empty()) {
+    const N* current = m_stack.back();
+    m_stack.pop_back();
+    m_sorted.push_back(current);
+    for (auto child : current->children()) {
+      auto found = m_incoming.find(child);
+      if (found != m_incoming.end() && --found->second == 0) m_stack.push_back(child);
+    }
+  }
+  if (m_sorted.size() != m_component.size()) return false;  // the nodes left over are on a cycle
+  // the links between these nodes agree with the order, only the links to tracked nodes may not
+  for (auto current : m_sorted) {
+    m_order.emplace(current, m_next++);
+    m_added.push_back(current);
+    for (auto child : current->children())
+      if (contains(*child) && !follow(current, child)) return false;
+  }
+  return true;
+}
+
+/// stop tracking the nodes tracked by the current call (the order of the others stays valid)
+template <typename N>
+void DynamicTopologicalOrder<N>::untrack() {
+  for (auto node : m_added)
+    m_order.erase(node);
+  m_added.clear();
+}
+
+/**
+ change the order so that the link parent -> child agrees with it (Pearce-Kelly)
+ @param const N* parent
+ @param const N* child
+ @return bool - false if the parent is a descendant of the child (the order is not changed)
+ */
+template <typename N>
+bool DynamicTopologicalOrder<N>::follow(const N* parent, const N* child) {
+  long lower = m_order[child];
+  long upper = m_order[parent];
+  if (lower < upper) {  // the order has to change
+    if (searchForward(child, parent, upper)) return false;
+    searchBackward(parent, lower);
+    reorder();
+  }
+  return true;
+}
+
+/// depth first search of the descendants of from (following every link), true if to is found
+template <typename N>
+bool DynamicTopologicalOrder<N>::reaches(const N* from, const N* to) {
+  m_visited.clear();
+  m_stack.assign(1, from);
+  m_visited.insert(from);
+  while (!m_stack.empty()) {
+    const N* node = m_stack.back();
+    m_stack.pop_back();
+    for (auto next : node->children()) {
+      if (next == to) return true;
+      if (m_visited.insert(next).second) m_stack.push_back(next);
+    }
+  }
+  return false;
+}
+
+template <typename N>
+void DynamicTopologicalOrder<N>::removeNode(N& node) {
+  node.detach();
+  m_order.erase(&node);
+}
+
+template <typename N>
+bool DynamicTopologicalOrder<N>::canAddChild(const N& parent, const N& child) {
+  if (&parent == &child) return false;
+  if (!contains(parent) || !contains(child)) return !reaches(&child, &parent);  // the order does not cover them
+  long upper = m_order[&parent];
+  if (m_order[&child] > upper) return true;
+  return !searchForward(&child, &parent, upper);
+}
+
+/**
+ add a link if it keeps the graph acyclic and update the topological order
+ @param N& parent
+ @param N& child
+ @return bool - false if the link would have created a cycle (nothing is changed)
+ */
+template <typename N>
+bool DynamicTopologicalOrder<N>::addChild(N& parent, N& child) {
+  if (&parent == &child) return false;
+  m_added.clear();
+  if (!track(parent) || !track(child) || !follow(&parent, &child)) {
+    untrack();  // the nodes tracked for this link
+    return false;
+  }
+  parent.addChild(child);
+  return true;
+}
+
+/**
+ depth first search of the descendants of the child whose position is before the parent
+ @param const N* child - start of the search
+ @param const N* parent - the node that would close a cycle
+ @param long upper - position of the parent
+ @return bool - true if the parent was found (a cycle)
+ */
+template <typename N>
+bool DynamicTopologicalOrder<N>::searchForward(const N* child, const N* parent, long upper) {
+  m_visited.clear();
+  m_forward.clear();
+  m_stack.assign(1, child);
+  m_visited.insert(child);
+  while (!m_stack.empty()) {
+    const N* node = m_stack.back();
+    m_stack.pop_back();
+    m_forward.push_back(node);
+    for (auto next : node->children()) {
+      if (next == parent) return true;
+      auto found = m_order.find(next);
+      if (found != m_order.end() && found->second < upper && m_visited.insert(next).second) m_stack.push_back(next);
+    }
+  }
+  return false;
+}
+
+/**
+ depth first search of the ancestors of the parent whose position is after the child
+ @param const N* parent - start of the search
+ @param long lower - position of the child
+ @return void
+ */
+template <typename N>
+void DynamicTopologicalOrder<N>::searchBackward(const N* parent, long lower) {
+  m_backward.clear();
+  m_stack.assign(1, parent);
+  m_visited.insert(parent);  // the forward and backward regions never overlap (no cycle)
+  while (!m_stack.empty()) {
+    const N* node = m_stack.back();
+    m_stack.pop_back();
+    m_backward.push_back(node);
+    for (auto next : node->parents()) {
+      auto found = m_order.find(next);
+      if (found != m_order.end() && found->second > lower && m_visited.insert(next).second) m_stack.push_back(next);
+    }
+  }
+}
+
+/// give the ancestors of the parent the first of the affected positions and the descendants of the child the rest
+template <typename N>
+void DynamicTopologicalOrder<N>::reorder() {
+  auto byPosition = [this](const N* a, const N* b) { return m_order[a] < m_order[b]; };
+  std::sort(m_backward.begin(), m_backward.end(), byPosition);
+  std::sort(m_forward.begin(), m_forward.end(), byPosition);
+  m_positions.clear();
+  for (auto node : m_backward)
+    m_positions.push_back(m_order[node]);
+  for (auto node : m_forward)
+    m_positions.push_back(m_order[node]);
+  std::sort(m_positions.begin(), m_positions.end());
+  std::size_t i = 0;
+  for (auto node : m_backward)
+    m_order[node] = m_positions[i++];
+  for (auto node : m_forward)
+    m_order[node] = m_positions[i++];
+}
+}
+
+#endif /* DynamicTopologicalOrder_h */
@@ -0,0 +1,95 @@
+#ifndef DAG_EVENTBATCH_H
+#define DAG_EVENTBATCH_H
+/** @class   DAG::EventBatch
+ *
+ *  @brief EventBatch finds the blocks of many independent event graphs, spread over a ThreadPool
+ *
+ *   Each worker thread owns a FloodFill and a Blocks buffer that are reused for every event it processes, so
+ *   once the buffers have grown to the size of the largest event no memory is allocated per event. The events
+ *   are handed out to the workers a few at a time (setGrainSize) from a shared counter, so workers that get
+ *   small events simply take more of them.
+ *
+ *   The handler is called on the worker thread with the blocks of one event; the blocks are only valid during
+ *   the call. The worker number can be used to index per-worker output (there are workers() of them).
+ *
+ *  Example usage:
+ *
+ std::vector<std::vector<INode>> events = readEvents();
+ DAG::ThreadPool pool(8);
+ DAG::EventBatch<int> batch(&pool);
+ std::vector<std::size_t> blocks(events.size());
+ batch.process(events, [&](std::size_t event, const DAG::FloodFill<int>::Blocks& found, unsigned worker) {
+   blocks[event] = found.size();
+ });
+ *
+ */
+
+#include "FloodFill.h"
+#include "ThreadPool.h"
+#include <atomic>
+
+namespace DAG {
+/// EventBatch processes independent graphs in parallel with per worker scratch space
+template <typename T>  /// T is what goes inside of a Node eg a long Id
+class EventBatch {
+public:
+  typedef typename FloodFill<T>::Blocks Blocks;
+  typedef typename FloodFill<T>::LinkPredicate LinkPredicate;
+  /// receives the blocks of one event on the worker that found them
+  typedef std::function<void(std::size_t event, const Blocks& blocks, unsigned worker)> BlockHandler;
+
+  /// the pool is optional, without it everything runs on the calling thread
+  explicit EventBatch(ThreadPool* pool = nullptr);
+  /**
+   find the blocks of each event
+   @param const Events& events - random access container, events[i] is any range of nodes accepted by FloodFill
+   @param const BlockHandler& handler - called once per event (in no particular order)
+   @return void
+   */
+  template <typename Events>
+  void process(const Events& events, const BlockHandler& handler) {
+    process(events, [](const Node<T>*, const Node<T>*) { return true; }, handler);
+  }
+  /// the same only using the links that pass the predicate
+  template <typename Events>
+  void process(const Events& events, const LinkPredicate& keep, const BlockHandler& handler);
+  /// number of workers (and of scratch spaces)
+  unsigned workers() const { return m_scratch.size(); }
+  /// number of events a worker takes at a time
+  void setGrainSize(std::size_t grain) { m_grain = std::max<std::size_t>(grain, 1); }
+
+private:
+  struct Scratch {
+    FloodFill<T> fill;
+    Blocks blocks;
+  };
+  ThreadPool* m_pool;
+  std::size_t m_grain;
+  std::vector<Scratch> m_scratch;
+};
+
+/// Constructor
+template <typename T>
+EventBatch<T>::EventBatch(ThreadPool* pool) : m_pool(pool), m_grain(16), m_scratch(pool ? pool->size() : 1) {}
+
+template <typename T>
+template <typename Events>
+void EventBatch<T>::process(const Events& events, const LinkPredicate& keep, const BlockHandler& handler) {
+  std::size_t count = events.size();
+  std::atomic<std::size_t> next(0);
+  auto work = [&](unsigned worker) {
+    Scratch& scratch = m_scratch[worker];
+    for (std::size_t begin = next.fetch_add(m_grain); begin < count; begin = next.fetch_add(m_grain))
+      for (std::size_t event = begin; event < std::min(begin + m_grain, count); ++event) {
+        scratch.fill.fill(events[event], keep, scratch.blocks);
+        handler(event, scratch.blocks, worker);
+      }
+  };
+  if (m_pool && count > m_grain)
+    m_pool->parallelFor(m_scratch.size(), [&work](std::size_t, std::size_t, unsigned chunk) { work(chunk); });
+  else
+    work(0);
+}
+}
+
+#endif /* EventBatch_h */
@@ -28,50 +28,161 @@
  std::cout<< std::endl;
 
  *
+ *   Links can be filtered: traverse(nodes, keep) only follows the links for which keep(parent, child) is true.
+ *   Given a weight for each link and a list of thresholds, traverse(nodes, weight, thresholds) finds the blocks
+ *   for all of the thresholds in a single pass (links are kept if weight <= threshold). The links are sorted by
+ *   weight and merged with a union-find, the blocks are recorded each time a threshold is passed. The blocks of
+ *   a threshold are contained in the blocks of the next larger threshold, so the result is a hierarchy.
+ *
+ *   stream(nodes, handler) hands each block to the handler as soon as it is complete instead of collecting them,
+ *   so that the processing of a block can start before the other blocks are found. stream(nodes, pool, handler)
+ *   runs the handler for each block as a task of a ThreadPool while the search goes on; the number of blocks
+ *   waiting for (or being processed by) the pool is bounded, which also bounds the memory held by the blocks.
+ *
+ *   The nodes may be given in any container (or range) of nodes, of node pointers or of (key, node) pairs such
+ *   as std::map, std::unordered_map or std::vector, they are used in place and not copied. A frozen CompactGraph
+ *   can also be filled, its index arrays are then used instead of the node links, and so can a LayeredGraph using
+ *   the links of the layers given by a LayerMask.
  *
  *  @author  Alice Robson
  *  @date    2016-04-12
  */
 
+#include "BlockBuffer.h"
+#include "CompactGraph.h"
 #include "DirectedAcyclicGraph.h"
+#include "LayeredGraph.h"
+#include "PointerSet.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
 
 namespace DAG {
 ///FloodFill creates blocks of connected elements
-template <typename T>  /// T is what goes inside of a Node eg a long Id
+template <typename T, typename Allocator = std::allocator<void>>  /// T is what goes inside of a Node eg a long Id
 class FloodFill {
 
-  typedef Node<T> TNode;
+  typedef Node<T, Allocator> TNode;
   typedef std::map<T, TNode> Nodemap;
-  typedef std::unordered_set<const TNode*> Nodeset;
-  typedef std::vector<const TNode*> Nodevector;
+  typedef PointerSet<const TNode*, NodeAllocatorFor<TNode, const TNode*>> Nodeset;
+  typedef DAG::Nodevector<TNode> Nodevector;
+  /// a vector using the allocator
+  template <typename V>
+  using Vector = std::vector<V, NodeAllocatorFor<TNode, V>>;
 
 public:
-  FloodFill();
+  /// decides if a link parent -> child is used
+  typedef std::function<bool(const TNode* parent, const TNode* child)> LinkPredicate;
+  /// gives the weight (eg distance) of a link parent -> child
+  typedef std::function<double(const TNode* parent, const TNode* child)> LinkWeight;
+  /// the blocks found for one threshold
+  /// the blocks found by traverse (uses the allocator, so it is a std::vector of std::vector by default)
+  typedef Vector<Nodevector> Blocklist;
+  struct BlockLevel {
+    double threshold;
+    Blocklist blocks;
+    /// position of the block containing each block in the next level (npos for the last level)
+    Vector<std::size_t> parents;
+  };
+  /// the blocks of each threshold (a std::vector by default)
+  typedef Vector<BlockLevel> Levels;
+  /// receives each block as soon as it is found (the handler may move the block away)
+  typedef std::function<void(Nodevector& block)> BlockHandler;
+  static const std::size_t npos = ~std::size_t(0);
+  /// blocks stored one after the other in one array, so that they can be refilled without allocating
+  typedef BlockBuffer<const TNode*, NodeAllocatorFor<TNode, const TNode*>> Blocks;
+
+  /// the allocator is used for the results and for the internal buffers
+  explicit FloodFill(const Allocator& allocator = Allocator());
   /// Return a vector that itself contains vectors of connected nodes
-  std::vector<Nodevector> traverse(Nodemap&);
+  template <typename Range>
+  Blocklist traverse(const Range& nodes);
+  /// Return the blocks of connected nodes only using the links that pass the predicate
+  template <typename Range>
+  Blocklist traverse(const Range& nodes, const LinkPredicate& keep);
+  /// Return the blocks for each threshold (sorted from the smallest), using the links with weight <= threshold
+  template <typename Range>
+  Levels traverse(const Range& nodes, const LinkWeight& weight, std::vector<double> thresholds);
+  /// Return the blocks of a frozen graph (optionally only using the links that pass the predicate)
+  Blocklist traverse(const CompactGraph<TNode>& graph) {
+    return traverse(graph, [](const TNode*, const TNode*) { return true; });
+  }
+  Blocklist traverse(const CompactGraph<TNode>& graph, const LinkPredicate& keep);
+  /// Return the blocks of a LayeredGraph using the links of the selected layers (all of them by default)
+  Blocklist traverse(const LayeredGraph<TNode>& graph, LayerMask layers = LayerMask::all());
+
+  /// Give each block to the handler as soon as it is found (optionally only using the links that pass the predicate)
+  template <typename Range>
+  void stream(const Range& nodes, const BlockHandler& handler) {
+    stream(nodes, [](const TNode*, const TNode*) { return true; }, handler);
+  }
+  template <typename Range>
+  void stream(const Range& nodes, const LinkPredicate& keep, const BlockHandler& handler);
+  /// Process each block on the pool as soon as it is found, with at most maxInFlight blocks queued or running
+  /// (0 = twice the pool size). Returns once every block has been processed.
+  template <typename Range>
+  void stream(const Range& nodes, ThreadPool& pool, const BlockHandler& handler, std::size_t maxInFlight = 0);
+
+  /// Replace the content of blocks by the blocks of the nodes (no allocation once the buffers are large enough)
+  template <typename Range>
+  void fill(const Range& nodes, Blocks& blocks) {
+    fill(nodes, [](const TNode*, const TNode*) { return true; }, blocks);
+  }
+  template <typename Range>
+  void fill(const Range& nodes, const LinkPredicate& keep, Blocks& blocks);
 
 private:
+  // the node of each kind of container element
+  static const TNode* pointer(const TNode& node) { return &node; }
+  static const TNode* pointer(const TNode* node) { return node; }
+  template <typename K>
+  static const TNode* pointer(const std::pair<const K, TNode>& elem) {
+    return &elem.second;
+  }
+  /// undirected BFS from start that skips the links failing the predicate, the block is appended to queue
+  void search(const TNode* start, const LinkPredicate& keep, Nodevector& queue);
+  /// blocks of a frozen graph, links(node, f) calls f(other end) for each usable link of the node
+  template <typename F>
+  Blocklist searchIndices(const CompactGraph<TNode>& graph, F links);
+
   /// which nodes have been visited (reset each time a traversal is made)
+  Allocator m_allocator;
   Nodeset m_visited;
+  Nodevector m_queue;
+  Vector<typename CompactGraph<TNode>::Index> m_indexQueue;
+  Vector<char> m_reached;
 };
 
-template <typename T>
-FloodFill<T>::FloodFill() {}
+template <typename T, typename Allocator>
+const std::size_t FloodFill<T, Allocator>::npos;
 
-template <typename T>
-std::vector<typename FloodFill<T>::Nodevector> FloodFill<T>::traverse(FloodFill<T>::Nodemap& nodes) {
-  std::vector<Nodevector> resultsVector;
+/// Constructor
+template <typename T, typename Allocator>
+FloodFill<T, Allocator>::FloodFill(const Allocator& allocator)
+    : m_allocator(allocator), m_visited(typename Nodeset::allocator_type(allocator)),
+      m_queue(typename Nodevector::allocator_type(allocator)),
+      m_indexQueue(typename Vector<typename CompactGraph<TNode>::Index>::allocator_type(allocator)),
+      m_reached(typename Vector<char>::allocator_type(allocator)) {}
 
-  m_visited.clear();
-  BFSVisitor<TNode> bfs;
+template <typename T, typename Allocator>
+template <typename Range>
+typename FloodFill<T, Allocator>::Blocklist FloodFill<T, Allocator>::traverse(const Range& nodes) {
+  Blocklist resultsVector(m_allocator);
 
-  for (auto& elem : nodes) {
+  m_visited.clear();
+  BFSVisitor<TNode> bfs(m_allocator);
 
-    if (m_visited.find(&elem.second) != m_visited.end()) continue;  // already done this node so skip the rest
+  for (const auto& elem : nodes) {
+    const TNode* start = pointer(elem);
+    if (m_visited.contains(start)) continue;  // already done this node so skip the rest
 
     // do a BFS search on any node that has not yet been visited
-    Nodevector result = bfs.traverseUndirected(elem.second);
+    const Nodevector& result = bfs.traverseUndirected(*start);
     for (const TNode* n : result)
       m_visited.insert(n);  // mark these as visited
 
@@ -79,6 +190,251 @@ std::vector<typename FloodFill<T>::Nodevector> FloodFill<T>::traverse(FloodFill<
   }
   return resultsVector;  // Move
 }
+
+/**
+ blocks of nodes that are connected by links passing a predicate
+ @param const Range& nodes - the start nodes (nodes linked to them are included in the blocks)
+ @param const LinkPredicate& keep - keep(parent, child) is true if the link is to be used
+ @return Blocklist - the blocks
+ */
+template <typename T, typename Allocator>
+template <typename Range>
+typename FloodFill<T, Allocator>::Blocklist FloodFill<T, Allocator>::traverse(const Range& nodes, const LinkPredicate& keep) {
+  Blocklist resultsVector(m_allocator);
+  stream(nodes, keep, [&resultsVector](Nodevector& block) { resultsVector.push_back(block); });
+  return resultsVector;
+}
+
+/**
+ find the blocks one at a time and give each to the handler before looking for the next
+ @param const Range& nodes - the start nodes (nodes linked to them are included in the blocks)
+ @param const LinkPredicate& keep - keep(parent, child) is true if the link is to be used
+ @param const BlockHandler& handler - called once for each block
+ @return void
+ */
+template <typename T, typename Allocator>
+template <typename Range>
+void FloodFill<T, Allocator>::stream(const Range& nodes, const LinkPredicate& keep, const BlockHandler& handler) {
+  m_visited.clear();
+  for (const auto& elem : nodes) {
+    const TNode* start = pointer(elem);
+    if (m_visited.contains(start)) continue;  // already done this node so skip the rest
+    m_queue.clear();
+    search(start, keep, m_queue);
+    handler(m_queue);
+  }
+}
+
+/**
+ find the blocks into a reusable flat buffer
+ @param const Range& nodes - the start nodes (nodes linked to them are included in the blocks)
+ @param const LinkPredicate& keep - keep(parent, child) is true if the link is to be used
+ @param Blocks& blocks - its content is replaced by the blocks
+ @return void
+ */
+template <typename T, typename Allocator>
+template <typename Range>
+void FloodFill<T, Allocator>::fill(const Range& nodes, const LinkPredicate& keep, Blocks& blocks) {
+  blocks.clear();
+  m_visited.clear();
+  for (const auto& elem : nodes) {
+    const TNode* start = pointer(elem);
+    if (m_visited.contains(start)) continue;
+    search(start, keep, blocks.nodes);
+    blocks.offsets.push_back(blocks.nodes.size());
+  }
+}
+
+template <typename T, typename Allocator>
+void FloodFill<T, Allocator>::search(const TNode* start, const LinkPredicate& keep, Nodevector& queue) {
+  // the queue is also the block
+  m_visited.insert(start);
+  queue.push_back(start);
+  for (std::size_t i = queue.size() - 1; i < queue.size(); ++i) {
+    const TNode* node = queue[i];
+    for (auto child : node->children())
+      if (!m_visited.contains(child) && keep(node, child)) {
+        m_visited.insert(child);
+        queue.push_back(child);
+      }
+    for (auto parent : node->parents())
+      if (!m_visited.contains(parent) && keep(parent, node)) {
+        m_visited.insert(parent);
+        queue.push_back(parent);
+      }
+  }
+}
+
+/**
+ process the blocks on a pool while the search goes on
+ @param const Range& nodes - the start nodes (nodes linked to them are included in the blocks)
+ @param ThreadPool& pool - runs the handler, must not be the pool running the caller
+ @param const BlockHandler& handler - called once for each block, from the pool threads
+ @param std::size_t maxInFlight - the search waits when this many blocks are queued or running
+ @return void
+ */
+template <typename T, typename Allocator>
+template <typename Range>
+void FloodFill<T, Allocator>::stream(const Range& nodes, ThreadPool& pool, const BlockHandler& handler, std::size_t maxInFlight) {
+  if (maxInFlight == 0) maxInFlight = 2 * pool.size();
+  std::deque<std::future<void>> inFlight;
+  try {
+    stream(nodes, [&](Nodevector& found) {
+      if (inFlight.size() >= maxInFlight) {  // wait for the oldest block to be done
+        std::future<void> oldest = std::move(inFlight.front());
+        inFlight.pop_front();
+        oldest.get();
+      }
+      auto block =
+          std::allocate_shared<Nodevector>(NodeAllocatorFor<TNode, Nodevector>(m_allocator), std::move(found));
+      inFlight.push_back(pool.submit([&handler, block]() { handler(*block); }));
+    });
+    while (!inFlight.empty()) {
+      std::future<void> oldest = std::move(inFlight.front());
+      inFlight.pop_front();
+      oldest.get();  // rethrows an exception from the handler
+    }
+  } catch (...) {
+    for (auto& running : inFlight)  // the tasks use the handler, so they must end before returning
+      running.wait();
+    throw;
+  }
+}
+
+/**
+ blocks for several weight thresholds in one pass
+ @param const Range& nodes - the nodes to be grouped (links to nodes outside the range are ignored)
+ @param const LinkWeight& weight - weight of each link
+ @param std::vector<double> thresholds - a link is used for a threshold if its weight is <= the threshold
+ @return Levels - the blocks for each threshold, from the smallest threshold to the largest
+ */
+template <typename T, typename Allocator>
+template <typename Range>
+typename FloodFill<T, Allocator>::Levels FloodFill<T, Allocator>::traverse(const Range& nodes, const LinkWeight& weight,
+                                                                           std::vector<double> thresholds) {
+  typedef Vector<std::size_t> Positions;
+  std::sort(thresholds.begin(), thresholds.end());
+  // number the nodes and collect the links
+  Nodevector all(m_allocator);
+  std::unordered_map<const TNode*, std::size_t, std::hash<const TNode*>, std::equal_to<const TNode*>,
+                     NodeAllocatorFor<TNode, std::pair<const TNode* const, std::size_t>>>
+      index(0, m_allocator);
+  for (const auto& elem : nodes) {
+    if (index.emplace(pointer(elem), all.size()).second) all.push_back(pointer(elem));
+  }
+  struct Link {
+    double weight;
+    std::size_t parent;
+    std::size_t child;
+  };
+  Vector<Link> links(m_allocator);
+  for (std::size_t i = 0; i < all.size(); ++i)
+    for (auto child : all[i]->children()) {
+      auto found = index.find(child);
+      if (found != index.end()) links.push_back(Link{weight(all[i], child), i, found->second});
+    }
+  std::sort(links.begin(), links.end(), [](const Link& a, const Link& b) { return a.weight < b.weight; });
+
+  // union-find over the nodes, links are merged in order of weight
+  Positions root(all.size(), 0, m_allocator);
+  std::iota(root.begin(), root.end(), 0);
+  auto find = [&root](std::size_t i) {
+    while (root[i] != i) {
+      root[i] = root[root[i]];  // path halving
+      i = root[i];
+    }
+    return i;
+  };
+
+  Levels levels(m_allocator);
+  Positions blockOf(all.size(), 0, m_allocator);     // block of each node in the current level
+  Positions previousOf(all.size(), 0, m_allocator);  // block of each node in the previous level
+  Positions blockOfRoot(all.size(), 0, m_allocator);
+  auto link = links.begin();
+  for (double threshold : thresholds) {
+    for (; link != links.end() && link->weight <= threshold; ++link) {
+      std::size_t a = find(link->parent);
+      std::size_t b = find(link->child);
+      if (a != b) root[a] = b;
+    }
+    // record the blocks of this threshold
+    levels.push_back(BlockLevel{threshold, Blocklist(m_allocator), Positions(m_allocator)});
+    BlockLevel& level = levels.back();
+    std::fill(blockOfRoot.begin(), blockOfRoot.end(), npos);
+    for (std::size_t i = 0; i < all.size(); ++i) {
+      std::size_t r = find(i);
+      if (blockOfRoot[r] == npos) {
+        blockOfRoot[r] = level.blocks.size();
+        level.blocks.emplace_back();
+      }
+      blockOf[i] = blockOfRoot[r];
+      level.blocks[blockOf[i]].push_back(all[i]);
+    }
+    // each block of the previous level lies inside one block of this level
+    if (levels.size() > 1) {
+      BlockLevel& previous = levels[levels.size() - 2];
+      previous.parents.assign(previous.blocks.size(), npos);
+      for (std::size_t i = 0; i < all.size(); ++i)
+        previous.parents[previousOf[i]] = blockOf[i];
+    }
+    level.parents.assign(level.blocks.size(), npos);
+    previousOf.swap(blockOf);
+  }
+  return levels;
+}
+/**
+ blocks of a frozen graph, searched over its index arrays
+ @param const CompactGraph<TNode>& graph - the graph
+ @param const LinkPredicate& keep - keep(parent, child) is true if the link is to be used
+ @return Blocklist - the blocks
+ */
+template <typename T, typename Allocator>
+typename FloodFill<T, Allocator>::Blocklist FloodFill<T, Allocator>::traverse(const CompactGraph<TNode>& graph,
+                                                                      const LinkPredicate& keep) {
+  typedef typename CompactGraph<TNode>::Index Index;
+  return searchIndices(graph, [&graph, &keep](Index node, auto f) {
+    for (Index child : graph.children(node))
+      if (keep(graph.node(node), graph.node(child))) f(child);
+    for (Index parent : graph.parents(node))
+      if (keep(graph.node(parent), graph.node(node))) f(parent);
+  });
+}
+
+template <typename T, typename Allocator>
+typename FloodFill<T, Allocator>::Blocklist FloodFill<T, Allocator>::traverse(const LayeredGraph<TNode>& graph,
+                                                                      LayerMask layers) {
+  typedef typename CompactGraph<TNode>::Index Index;
+  return searchIndices(graph.graph(), [&graph, layers](Index node, auto f) {
+    graph.forEachLink(node, VisitType::UNDIRECTED, layers, [&f](const CompactLink& link) { f(link.node); });
+  });
+}
+
+template <typename T, typename Allocator>
+template <typename F>
+typename FloodFill<T, Allocator>::Blocklist FloodFill<T, Allocator>::searchIndices(const CompactGraph<TNode>& graph,
+                                                                           F links) {
+  typedef typename CompactGraph<TNode>::Index Index;
+  Blocklist resultsVector(m_allocator);
+  m_reached.assign(graph.size(), 0);
+  for (Index start = 0; start < graph.size(); ++start) {
+    if (m_reached[start]) continue;
+    m_reached[start] = 1;
+    m_indexQueue.assign(1, start);
+    for (std::size_t i = 0; i < m_indexQueue.size(); ++i)
+      links(m_indexQueue[i], [this](Index other) {
+        if (!m_reached[other]) {
+          m_reached[other] = 1;
+          m_indexQueue.push_back(other);
+        }
+      });
+    resultsVector.emplace_back();
+    Nodevector& block = resultsVector.back();
+    block.reserve(m_indexQueue.size());
+    for (Index i : m_indexQueue)
+      block.push_back(graph.node(i));
+  }
+  return resultsVector;
+}
 }
 
 #endif /* FloodFill_h */
@@ -0,0 +1,144 @@
+#ifndef DAG_GRAPHBFS_H
+#define DAG_GRAPHBFS_H
+/** @class   DAG::GraphBFS
+ *
+ *  @brief GraphBFS is a breadth first search over any graph described by GraphTraits
+ *
+ *   The graph is read in place through GraphTraits<G> (see GraphTraits.h), so the nodes do not have to be Nodes
+ *   or be copied into a CompactGraph. The visited marks are kept in an array indexed by GraphTraits::index and
+ *   are cleared in constant time between searches. Results are given level by level (levelOffsets) and the
+ *   buffers are kept between searches.
+ *
+ *   search() is the engine of the traversals: the caller gives the links to follow from each node, so searches
+ *   that filter the links or read them from elsewhere reuse the same queue and visited marks (CompactBFS is a
+ *   GraphBFS over a CompactGraph with link predicates, node tags and layers).
+ *
+ *  Example usage:
+ *
+ DAG::GraphBFS<Event> bfs(event);
+ for (int particle : bfs.traverse(0, DAG::VisitType::CHILDREN))
+   std::cout << particle << std::endl;
+ *
+ */
+
+#include "GraphTraits.h"
+#include "Prefetch.h"
+#include <algorithm>
+#include <vector>
+
+namespace DAG {
+/// GraphBFS is a breadth first search over the handles of a graph adapted by GraphTraits
+template <typename G>  /// G is the graph
+class GraphBFS {
+public:
+  typedef GraphTraits<G> Traits;
+  typedef typename Traits::Handle Handle;
+
+  explicit GraphBFS(const G& graph);
+  /// visit everything linked to the start node(s) (depth -1 = everything, 0 = start node(s) only)
+  const std::vector<Handle>& traverse(Handle start, VisitType visittype, int depth = -1) {
+    m_start.assign(1, start);
+    return traverse(m_start, visittype, depth);
+  }
+  const std::vector<Handle>& traverse(const std::vector<Handle>& starts, VisitType visittype, int depth = -1);
+  /**
+   search with the links given by the caller
+   @param const std::vector<Handle>& starts - the start node(s)
+   @param int depth - how many levels to visit (-1 = everything)
+   @param E expand - expand(std::size_t k, Handle node, add) is called for the node at position k of the results
+   and calls add(Handle) for each node linked to it that the search is to visit (add skips the visited ones)
+   @return const std::vector<Handle>& - the nodes found, level by level
+   */
+  template <typename E>
+  const std::vector<Handle>& search(const std::vector<Handle>& starts, int depth, E expand);
+
+  /// the nodes found by the last search
+  const std::vector<Handle>& result() const { return m_result; }
+  /// level k is found at [levelOffsets()[k], levelOffsets()[k+1]) in the results
+  const std::vector<std::size_t>& levelOffsets() const { return m_levelOffsets; }
+  bool visited(Handle h) const { return m_stamp[Traits::index(*m_graph, h)] == m_current; }
+  /// start loading the visited mark of a node that is about to be looked at (see CompactBFS::setPrefetchDistance)
+  void prefetchVisited(Handle h) const { prefetch(&m_stamp[Traits::index(*m_graph, h)]); }
+
+private:
+  const G* m_graph;
+  std::vector<Handle> m_start;              ///< the start node of a search from a single node
+  std::vector<Handle> m_result;             ///< also used as the queue: each level is processed in place
+  std::vector<std::size_t> m_levelOffsets;  ///< start of each level in m_result (plus the end)
+  std::vector<unsigned> m_stamp;            ///< search number that last visited each node
+  unsigned m_current;                       ///< number of the current search
+
+  void reset();
+  /// mark a node and queue it if it had not been visited yet
+  void add(Handle h) {
+    unsigned& stamp = m_stamp[Traits::index(*m_graph, h)];
+    if (stamp != m_current) {
+      stamp = m_current;
+      m_result.push_back(h);
+    }
+  }
+};
+
+/// Constructor
+template <typename G>
+GraphBFS<G>::GraphBFS(const G& graph) : m_graph(&graph), m_current(0) {}
+
+/// start a new search, nodes are visited if their stamp is the current search number
+template <typename G>
+void GraphBFS<G>::reset() {
+  std::size_t size = Traits::size(*m_graph);
+  if (m_stamp.size() != size) {
+    m_stamp.assign(size, 0);
+    m_current = 0;
+  }
+  if (++m_current == 0) {  // the stamps have wrapped around
+    std::fill(m_stamp.begin(), m_stamp.end(), 0);
+    m_current = 1;
+  }
+  m_result.clear();
+  m_levelOffsets.clear();
+}
+
+/**
+ level by level breadth first search following the children and/or parents given by GraphTraits
+ @param const std::vector<Handle>& starts - the start node(s)
+ @param VisitType visittype - CHILDREN/PARENTS/UNDIRECTED
+ @param int depth - how many levels to visit (-1 = everything, 0 = start node(s), 2= start node plus 2 levels)
+ @return const std::vector<Handle>& - the nodes found, level by level
+ */
+template <typename G>
+const std::vector<typename GraphBFS<G>::Handle>& GraphBFS<G>::traverse(const std::vector<Handle>& starts,
+                                                                       VisitType visittype, int depth) {
+  return search(starts, depth, [this, visittype](std::size_t, Handle node, auto add) {
+    if (visittype != VisitType::PARENTS)
+      for (Handle child : Traits::children(*m_graph, node))
+        add(child);
+    if (visittype != VisitType::CHILDREN)
+      for (Handle parent : Traits::parents(*m_graph, node))
+        add(parent);
+  });
+}
+
+template <typename G>
+template <typename E>
+const std::vector<typename GraphBFS<G>::Handle>& GraphBFS<G>::search(const std::vector<Handle>& starts, int depth,
+                                                                     E expand) {
+  reset();
+  m_levelOffsets.push_back(0);
+  for (Handle start : starts)
+    add(start);
+  auto queue = [this](Handle h) { add(h); };
+  std::size_t begin = 0;
+  for (int level = 0; begin < m_result.size(); ++level) {
+    std::size_t end = m_result.size();
+    m_levelOffsets.push_back(end);
+    if (level == depth) break;  // NB depth=-1 means we are visiting everything
+    for (std::size_t k = begin; k < end; ++k)
+      expand(k, m_result[k], queue);
+    begin = end;
+  }
+  return m_result;
+}
+}
+
+#endif /* GraphBFS_h */
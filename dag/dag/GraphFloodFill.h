@@ -0,0 +1,86 @@
+#ifndef DAG_GRAPHFLOODFILL_H
+#define DAG_GRAPHFLOODFILL_H
+/** @class   DAG::GraphFloodFill
+ *
+ *  @brief GraphFloodFill creates blocks of connected nodes of any graph described by GraphTraits
+ *
+ *   The same as FloodFill, but the graph is read in place through GraphTraits<G> (see GraphTraits.h) and the
+ *   blocks are lists of Handles. fill() stores the blocks one after the other in a Blocks buffer, so that
+ *   refilling it for the next graph does not allocate once it has grown.
+ *
+ *  Example usage:
+ *
+ DAG::GraphFloodFill<Event> ffill;
+ for (auto& block : ffill.traverse(event))
+   std::cout << "block of " << block.size() << " particles" << std::endl;
+ *
+ */
+
+#include "BlockBuffer.h"
+#include "GraphTraits.h"
+#include <vector>
+
+namespace DAG {
+/// GraphFloodFill finds the connected blocks of a graph adapted by GraphTraits
+template <typename G>  /// G is the graph
+class GraphFloodFill {
+public:
+  typedef GraphTraits<G> Traits;
+  typedef typename Traits::Handle Handle;
+  /// blocks stored one after the other in one array
+  typedef BlockBuffer<Handle> Blocks;
+
+  /// Return a vector that itself contains vectors of connected nodes
+  std::vector<std::vector<Handle>> traverse(const G& graph);
+  /// Replace the content of blocks by the blocks of the graph
+  void fill(const G& graph, Blocks& blocks);
+
+private:
+  std::vector<char> m_reached;  ///< by GraphTraits::index
+};
+
+template <typename G>
+std::vector<std::vector<typename GraphFloodFill<G>::Handle>> GraphFloodFill<G>::traverse(const G& graph) {
+  Blocks blocks;
+  fill(graph, blocks);
+  std::vector<std::vector<Handle>> resultsVector;
+  resultsVector.reserve(blocks.size());
+  for (std::size_t i = 0; i < blocks.size(); ++i)
+    resultsVector.emplace_back(blocks.block(i).begin(), blocks.block(i).end());
+  return resultsVector;
+}
+
+/**
+ undirected search from each node not yet reached, the nodes array is used as the queue
+ @param const G& graph - the graph
+ @param Blocks& blocks - replaced by the blocks of the graph
+ @return void
+ */
+template <typename G>
+void GraphFloodFill<G>::fill(const G& graph, Blocks& blocks) {
+  blocks.clear();
+  std::size_t size = Traits::size(graph);
+  m_reached.assign(size, 0);
+  auto add = [&](Handle h) {
+    char& reached = m_reached[Traits::index(graph, h)];
+    if (!reached) {
+      reached = 1;
+      blocks.nodes.push_back(h);
+    }
+  };
+  for (std::size_t start = 0; start < size; ++start) {
+    if (m_reached[start]) continue;
+    add(Traits::handle(graph, start));
+    for (std::size_t k = blocks.offsets.back(); k < blocks.nodes.size(); ++k) {
+      Handle node = blocks.nodes[k];
+      for (Handle child : Traits::children(graph, node))
+        add(child);
+      for (Handle parent : Traits::parents(graph, node))
+        add(parent);
+    }
+    blocks.offsets.push_back(blocks.nodes.size());
+  }
+}
+}
+
+#endif /* GraphFloodFill_h */
@@ -0,0 +1,114 @@
+#ifndef DAG_GRAPHTRAITS_H
+#define DAG_GRAPHTRAITS_H
+/** @class   DAG::GraphTraits
+ *
+ *  @brief GraphTraits describes how GraphBFS and GraphFloodFill read a graph
+ *
+ *   The algorithms of GraphBFS.h and GraphFloodFill.h only need, for a graph type G:
+ *    - Handle: how a node is referred to (an index, a pointer, an object id ...)
+ *    - size(g): the number of nodes
+ *    - index(g, h): a dense number 0..size(g)-1 for each node (used for the visited marks)
+ *    - handle(g, i): the node with dense number i
+ *    - children(g, h) and parents(g, h): ranges of Handles
+ *   so relations that are already stored in some other data structure (eg the mother and daughter lists of an
+ *   event store) can be searched in place, without copying them into Nodes.
+ *
+ *   By default GraphTraits<G> calls the members of G of the same names (G::Handle, g.size(), g.index(h),
+ *   g.handle(i), g.children(h), g.parents(h)). A type that cannot be given these members is adapted by
+ *   specialising GraphTraits for it. CompactGraph (and a LayeredGraph through its layer 0) is adapted here, with
+ *   the node index as the Handle. Nodes are searched through their own links by wrapping them in a NodeGraph,
+ *   which numbers them (the Handle is the node pointer).
+ *
+ *  Example usage:
+ *
+ struct Event {
+   std::vector<std::vector<int>> daughters, mothers;  // by particle number
+ };
+ namespace DAG {
+ template <>
+ struct GraphTraits<Event> {
+   typedef int Handle;
+   static std::size_t size(const Event& e) { return e.daughters.size(); }
+   static std::size_t index(const Event&, int particle) { return particle; }
+   static int handle(const Event&, std::size_t i) { return i; }
+   static const std::vector<int>& children(const Event& e, int particle) { return e.daughters[particle]; }
+   static const std::vector<int>& parents(const Event& e, int particle) { return e.mothers[particle]; }
+ };
+ }
+ DAG::GraphBFS<Event> bfs(event);
+ bfs.traverse(0, DAG::VisitType::CHILDREN);
+ *
+ */
+
+#include "CompactGraph.h"
+#include "LayeredGraph.h"
+#include <cassert>
+#include <unordered_map>
+
+namespace DAG {
+/// GraphTraits<G> gives the algorithms generic access to a graph of type G
+template <typename G>
+struct GraphTraits {
+  typedef typename G::Handle Handle;
+  static std::size_t size(const G& g) { return g.size(); }
+  static std::size_t index(const G& g, Handle h) { return g.index(h); }
+  static Handle handle(const G& g, std::size_t i) { return g.handle(i); }
+  static decltype(auto) children(const G& g, Handle h) { return g.children(h); }
+  static decltype(auto) parents(const G& g, Handle h) { return g.parents(h); }
+};
+
+/// NodeGraph numbers a set of Nodes so that GraphBFS and GraphFloodFill can follow the links of the Nodes
+/**
+ * Every node linked to a node of the set must be in the set (eg the set given by CompactGraph::connected), the
+ * links are read from the Nodes during the searches. Unlike a CompactGraph it is only built once: the nodes may
+ * be linked and unlinked afterwards, as long as the set stays closed.
+ */
+template <typename N>  /// N is the Node
+class NodeGraph {
+public:
+  typedef const N* Handle;
+
+  explicit NodeGraph(const Nodevector<N>& nodes) : m_nodes(nodes) {
+    m_index.reserve(nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+      m_index.emplace(nodes[i], i);
+  }
+  std::size_t size() const { return m_nodes.size(); }
+  std::size_t index(Handle node) const {
+    auto found = m_index.find(node);
+    assert(found != m_index.end() && "a NodeGraph must hold every node linked to its nodes");
+    return found->second;
+  }
+  Handle handle(std::size_t i) const { return m_nodes[i]; }
+  const typename N::Linkset& children(Handle node) const { return node->children(); }
+  const typename N::Linkset& parents(Handle node) const { return node->parents(); }
+
+private:
+  Nodevector<N> m_nodes;                              ///< node of each number
+  std::unordered_map<const N*, std::size_t> m_index;  ///< number of each node
+};
+
+/// a CompactGraph is searched by node index
+template <typename N>
+struct GraphTraits<CompactGraph<N>> {
+  typedef typename CompactGraph<N>::Index Handle;
+  static std::size_t size(const CompactGraph<N>& g) { return g.size(); }
+  static std::size_t index(const CompactGraph<N>&, Handle h) { return h; }
+  static Handle handle(const CompactGraph<N>&, std::size_t i) { return Handle(i); }
+  static typename CompactGraph<N>::Range children(const CompactGraph<N>& g, Handle h) { return g.children(h); }
+  static typename CompactGraph<N>::Range parents(const CompactGraph<N>& g, Handle h) { return g.parents(h); }
+};
+
+/// the links of layer 0 of a LayeredGraph
+template <typename N>
+struct GraphTraits<LayeredGraph<N>> {
+  typedef typename LayeredGraph<N>::Index Handle;
+  static std::size_t size(const LayeredGraph<N>& g) { return g.size(); }
+  static std::size_t index(const LayeredGraph<N>&, Handle h) { return h; }
+  static Handle handle(const LayeredGraph<N>&, std::size_t i) { return Handle(i); }
+  static typename LayeredGraph<N>::Range children(const LayeredGraph<N>& g, Handle h) { return g.children(h); }
+  static typename LayeredGraph<N>::Range parents(const LayeredGraph<N>& g, Handle h) { return g.parents(h); }
+};
+}
+
+#endif /* GraphTraits_h */
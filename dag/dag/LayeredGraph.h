@@ -0,0 +1,250 @@
+#ifndef DAG_LAYEREDGRAPH_H
+#define DAG_LAYEREDGRAPH_H
+/** @class   DAG::LayeredGraph
+ *
+ *  @brief LayeredGraph stores several named sets of links (layers) between one set of nodes
+ *
+ *   The same particles can be linked in several ways (eg the parent/daughter history and the reconstruction
+ *   links). Rather than building one graph of Nodes per kind of link, a LayeredGraph indexes the nodes once and
+ *   stores the links of each layer in index arrays of their own (compressed sparse row, as in CompactGraph).
+ *
+ *   Layer 0 holds the links of the Nodes themselves, in a CompactGraph given by graph(), so the algorithms that
+ *   take a CompactGraph (TopologicalSort, ReachabilityIndex ...) work on that layer. The CompactGraph is only
+ *   handed out as const: it is rebuilt and renumbered through the LayeredGraph, so that the other layers follow.
+ *   Further layers are added from lists of (parent, child) node pointers. CompactBFS and FloodFill accept a LayerMask
+ *   selecting the layers whose links are followed; forEachLink reports the layer of each link it visits.
+ *
+ *  Example usage:
+ *
+ DAG::LayeredGraph<INode> graph(nodes, "history");  // the links of the nodes
+ std::vector<std::pair<const INode*, const INode*>> reco{{&n0, &n5}, {&n2, &n6}};
+ graph.addLayer("reco", reco);
+ DAG::CompactBFS<INode> bfs(graph, graph.select({"history", "reco"}));
+ bfs.traverse(graph.index(&n0), DAG::VisitType::CHILDREN);
+ DAG::FloodFill<int> ffill;
+ auto blocks = ffill.traverse(graph, graph.select({"reco"}));
+ *
+ */
+
+#include "CompactGraph.h"
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+namespace DAG {
+/// set of layer numbers (0..63) of a LayeredGraph
+typedef TagMask LayerMask;
+
+/// LayeredGraph stores several layers of links over the nodes of a CompactGraph
+template <typename N>  /// N is the Node
+class LayeredGraph {
+public:
+  typedef typename CompactGraph<N>::Index Index;
+  typedef typename CompactGraph<N>::Range Range;
+  static const unsigned maxLayers = 64;
+  static const unsigned npos = ~0u;  ///< number of a layer that does not exist
+
+  LayeredGraph();
+  /// index the nodes, their own links become layer 0
+  explicit LayeredGraph(const Nodevector<N>& nodes, const std::string& name = "links");
+  /// start again from the given nodes (removes all the layers added)
+  void build(const Nodevector<N>& nodes, const std::string& name = "links");
+  /// renumber the nodes (see CompactGraph::permute), the links of every layer follow
+  void permute(const std::vector<Index>& order);
+  /// the same, also giving the old position of each link of layer 0 (for the EdgeColumns of graph())
+  void permute(const std::vector<Index>& order, std::vector<Index>& childSlots, std::vector<Index>& parentSlots);
+  /// give each node a type tag (see CompactGraph::setTags)
+  template <typename F>
+  void setTags(F tag) {
+    m_graph.setTags(tag);
+  }
+  /// the nodes and the links of layer 0
+  const CompactGraph<N>& graph() const { return m_graph; }
+
+  /// the nodes, as in CompactGraph
+  std::size_t size() const { return m_graph.size(); }
+  const N* node(Index i) const { return m_graph.node(i); }
+  const Nodevector<N>& nodes() const { return m_graph.nodes(); }
+  Index index(const N* node) const { return m_graph.index(node); }
+  bool contains(const N* node) const { return m_graph.contains(node); }
+  typename CompactGraph<N>::Tag tag(Index i) const { return m_graph.tag(i); }
+  /**
+   add a layer of links
+   @param const std::string& name - name of the layer
+   @param const Links& links - range of (const N* parent, const N* child) pairs, links to nodes that are not in
+   the graph are dropped
+   @return unsigned - the number of the new layer (npos if there are already maxLayers layers)
+   */
+  template <typename Links>
+  unsigned addLayer(const std::string& name, const Links& links);
+
+  /// number of layers (including layer 0)
+  unsigned layers() const { return m_names.size(); }
+  /// number of the layer with this name, npos if there is none
+  unsigned layer(const std::string& name) const;
+  const std::string& name(unsigned layer) const { return m_names[layer]; }
+  /// the layers with these names (names of no layer are ignored)
+  LayerMask select(std::initializer_list<std::string> names) const;
+  /// number of links of a layer
+  std::size_t edges(unsigned layer) const {
+    return layer == 0 ? m_graph.edges() : m_layers[layer - 1].children.size();
+  }
+  /// number of links of layer 0
+  std::size_t edges() const { return m_graph.edges(); }
+
+  /// children and parents of node i in one layer
+  Range children(Index i, unsigned layer) const;
+  Range parents(Index i, unsigned layer) const;
+  /// children and parents of node i in layer 0
+  Range children(Index i) const { return m_graph.children(i); }
+  Range parents(Index i) const { return m_graph.parents(i); }
+  /// call f(const CompactLink&) for each link of node i in the selected layers that is followed by the visit type
+  template <typename F>
+  void forEachLink(Index i, VisitType visittype, LayerMask layers, F f) const;
+  /// the same for the links of layer 0
+  template <typename F>
+  void forEachLink(Index i, VisitType visittype, F f) const {
+    m_graph.forEachLink(i, visittype, f);
+  }
+
+private:
+  /// the links of one layer, same layout as those of CompactGraph
+  struct Layer {
+    std::vector<Index> childOffsets;
+    std::vector<Index> children;
+    std::vector<Index> parentOffsets;
+    std::vector<Index> parents;
+  };
+  CompactGraph<N> m_graph;           ///< the nodes and layer 0
+  std::vector<std::string> m_names;  ///< name of each layer
+  std::vector<Layer> m_layers;       ///< layers 1.. (layer 0 is held by the CompactGraph)
+};
+
+template <typename N>
+const unsigned LayeredGraph<N>::maxLayers;
+template <typename N>
+const unsigned LayeredGraph<N>::npos;
+
+/// Constructor
+template <typename N>
+LayeredGraph<N>::LayeredGraph() : m_names(1, "links") {}
+
+/// Constructor
+template <typename N>
+LayeredGraph<N>::LayeredGraph(const Nodevector<N>& nodes, const std::string& name) {
+  build(nodes, name);
+}
+
+template <typename N>
+void LayeredGraph<N>::build(const Nodevector<N>& nodes, const std::string& name) {
+  m_graph.build(nodes);
+  m_names.assign(1, name);
+  m_layers.clear();
+}
+
+template <typename N>
+void LayeredGraph<N>::permute(const std::vector<Index>& order) {
+  std::vector<Index> childSlots, parentSlots;
+  permute(order, childSlots, parentSlots);
+}
+
+template <typename N>
+void LayeredGraph<N>::permute(const std::vector<Index>& order, std::vector<Index>& childSlots,
+                              std::vector<Index>& parentSlots) {
+  m_graph.permute(order, childSlots, parentSlots);
+  std::vector<Index> newIndex(order.size());
+  for (Index k = 0; k < order.size(); ++k)
+    newIndex[order[k]] = k;
+  std::vector<Index> slots;
+  for (Layer& layer : m_layers) {
+    permuteLinks(order, newIndex, layer.childOffsets, layer.children, slots);
+    permuteLinks(order, newIndex, layer.parentOffsets, layer.parents, slots);
+  }
+}
+
+/**
+ sort the links of a new layer into index arrays, counting the links of each node first
+ */
+template <typename N>
+template <typename Links>
+unsigned LayeredGraph<N>::addLayer(const std::string& name, const Links& links) {
+  if (m_names.size() == maxLayers) return npos;
+  std::vector<std::pair<Index, Index>> pairs;
+  for (const auto& link : links) {
+    Index parent = index(link.first);
+    Index child = index(link.second);
+    if (parent != CompactGraph<N>::npos && child != CompactGraph<N>::npos) pairs.emplace_back(parent, child);
+  }
+  Layer layer;
+  layer.childOffsets.assign(size() + 1, 0);
+  layer.parentOffsets.assign(size() + 1, 0);
+  for (const auto& link : pairs) {
+    ++layer.childOffsets[link.first + 1];
+    ++layer.parentOffsets[link.second + 1];
+  }
+  for (std::size_t i = 0; i < size(); ++i) {
+    layer.childOffsets[i + 1] += layer.childOffsets[i];
+    layer.parentOffsets[i + 1] += layer.parentOffsets[i];
+  }
+  layer.children.resize(pairs.size());
+  layer.parents.resize(pairs.size());
+  std::vector<Index> childEnd(layer.childOffsets.begin(), layer.childOffsets.end() - 1);
+  std::vector<Index> parentEnd(layer.parentOffsets.begin(), layer.parentOffsets.end() - 1);
+  for (const auto& link : pairs) {
+    layer.children[childEnd[link.first]++] = link.second;
+    layer.parents[parentEnd[link.second]++] = link.first;
+  }
+  m_layers.push_back(std::move(layer));
+  m_names.push_back(name);
+  return m_names.size() - 1;
+}
+
+template <typename N>
+unsigned LayeredGraph<N>::layer(const std::string& name) const {
+  for (unsigned i = 0; i < m_names.size(); ++i)
+    if (m_names[i] == name) return i;
+  return npos;
+}
+
+template <typename N>
+LayerMask LayeredGraph<N>::select(std::initializer_list<std::string> names) const {
+  LayerMask mask;
+  for (const auto& name : names) {
+    unsigned found = layer(name);
+    if (found != npos) mask.add(found);
+  }
+  return mask;
+}
+
+template <typename N>
+typename LayeredGraph<N>::Range LayeredGraph<N>::children(Index i, unsigned layer) const {
+  if (layer == 0) return children(i);
+  const Layer& l = m_layers[layer - 1];
+  return Range(l.children.data() + l.childOffsets[i], l.children.data() + l.childOffsets[i + 1]);
+}
+
+template <typename N>
+typename LayeredGraph<N>::Range LayeredGraph<N>::parents(Index i, unsigned layer) const {
+  if (layer == 0) return parents(i);
+  const Layer& l = m_layers[layer - 1];
+  return Range(l.parents.data() + l.parentOffsets[i], l.parents.data() + l.parentOffsets[i + 1]);
+}
+
+template <typename N>
+template <typename F>
+void LayeredGraph<N>::forEachLink(Index i, VisitType visittype, LayerMask layers, F f) const {
+  if (layers.contains(0)) forEachLink(i, visittype, f);
+  for (unsigned number = 1; number < m_names.size(); ++number) {
+    if (!layers.contains(number)) continue;
+    const Layer& l = m_layers[number - 1];
+    if (visittype != VisitType::PARENTS)
+      for (Index slot = l.childOffsets[i]; slot < l.childOffsets[i + 1]; ++slot)
+        f(CompactLink{l.children[slot], slot, false, number});
+    if (visittype != VisitType::CHILDREN)
+      for (Index slot = l.parentOffsets[i]; slot < l.parentOffsets[i + 1]; ++slot)
+        f(CompactLink{l.parents[slot], slot, true, number});
+  }
+}
+}
+
+#endif /* LayeredGraph_h */
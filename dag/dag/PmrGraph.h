@@ -0,0 +1,55 @@
+#ifndef DAG_PMRGRAPH_H
+#define DAG_PMRGRAPH_H
+/** @file PmrGraph.h
+ *
+ *  @brief Nodes, visitors and FloodFill whose memory comes from a std::pmr::memory_resource
+ *
+ *   The node links, the results and internal buffers of BFSVisitor and the blocks of FloodFill all use the
+ *   allocator of the node type. DAG::pmr::Node<T> uses std::pmr::polymorphic_allocator, so every container
+ *   belonging to an event can be given the same resource (for example a std::pmr::monotonic_buffer_resource)
+ *   and all of the memory of the event is released at once when the resource is destroyed. The nodes must then
+ *   not be used after the resource has gone.
+ *
+ *   The nodes use the resource they are constructed with (or that of the pmr container they are put in).
+ *   Visitors and FloodFill take the resource in their constructor, and so does FloodFill::Blocks. FloodFill uses
+ *   it for all of its work arrays, including those of the threshold hierarchy and of the CompactGraph and
+ *   LayeredGraph searches. The memory that does not come from the resource:
+ *    - containers made without one (eg inside CompactGraph and LayeredGraph) use std::pmr::get_default_resource()
+ *    - the vector of thresholds given to FloodFill::traverse is a std::vector (move it in to avoid a copy)
+ *    - std::function predicates and handlers may allocate when they hold large captures
+ *    - FloodFill::stream on a ThreadPool allocates the task and future of each block with operator new
+ *
+ *  Example usage:
+ *
+ std::pmr::monotonic_buffer_resource arena;
+ std::pmr::vector<DAG::pmr::Node<long>> nodes(&arena);
+ nodes.reserve(count);  // the nodes must not move once they are linked
+ for (long id = 0; id < count; ++id)
+   nodes.emplace_back(id);  // the links of each node are allocated in the arena
+ DAG::pmr::FloodFill<long> fill(&arena);
+ auto blocks = fill.traverse(nodes);
+ *
+ */
+
+#include "DirectedAcyclicGraph.h"
+#include "FloodFill.h"
+#include <cstddef>
+#include <memory_resource>
+
+namespace DAG {
+namespace pmr {
+/// allocator used by all of the pmr types
+typedef std::pmr::polymorphic_allocator<std::byte> Allocator;
+template <typename T>
+using Node = DAG::Node<T, Allocator>;
+template <typename T>
+using FloodFill = DAG::FloodFill<T, Allocator>;
+/// the visitors take the allocator of their nodes, so these are the usual visitors of pmr nodes
+template <typename T>
+using BFSVisitor = DAG::BFSVisitor<Node<T>>;
+template <typename T>
+using Nodevector = DAG::Nodevector<Node<T>>;
+}
+}
+
+#endif /* PmrGraph_h */
@@ -0,0 +1,137 @@
+#ifndef DAG_POINTERSET_H
+#define DAG_POINTERSET_H
+/** @class   DAG::PointerSet
+ *
+ *  @brief PointerSet is a set of pointers that can be cleared in constant time without freeing its memory
+ *
+ *   The traversals mark the nodes they have visited. With a std::unordered_set every insertion allocates a
+ *   hash node and every clear frees them all. PointerSet stores the pointers in a single open addressing table
+ *   (linear probing) and gives each slot the stamp of the traversal that filled it, so clear() only moves to a
+ *   new stamp. Once the table has grown to the size of the largest traversal no more memory is allocated.
+ *
+ *  Example usage:
+ *
+ DAG::PointerSet<const INode*> visited;
+ if (visited.insert(&n0)) std::cout << "first visit" << std::endl;
+ visited.clear();
+ *
+ */
+
+#include "Prefetch.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace DAG {
+/// PointerSet is an open addressing set of pointers with constant time clear
+template <typename P, typename Allocator = std::allocator<P>>  /// P is a pointer type
+class PointerSet {
+public:
+  typedef Allocator allocator_type;
+
+  explicit PointerSet(const Allocator& allocator = Allocator());
+  /// add a pointer, returns false if it was already in the set
+  bool insert(P pointer);
+  bool contains(P pointer) const;
+  /// start loading the slot where the pointer would be found (see Prefetch.h)
+  void prefetch(P pointer) const {
+    if (m_slots.empty()) return;
+    std::size_t i = hash(pointer);
+    DAG::prefetch(&m_stamps[i]);
+    DAG::prefetch(&m_slots[i]);
+  }
+  /// empty the set (constant time, the memory is kept)
+  void clear();
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  /// make room for this many pointers so that no allocation is needed until there are more
+  void reserve(std::size_t count);
+  allocator_type get_allocator() const { return m_slots.get_allocator(); }
+
+private:
+  typedef std::vector<unsigned, typename std::allocator_traits<Allocator>::template rebind_alloc<unsigned>> Stamps;
+  std::vector<P, Allocator> m_slots;
+  Stamps m_stamps;  ///< a slot is used if its stamp is the current stamp
+  unsigned m_stamp;
+  std::size_t m_size;
+
+  std::size_t hash(P pointer) const;
+  void rehash(std::size_t capacity);
+};
+
+/// Constructor
+template <typename P, typename Allocator>
+PointerSet<P, Allocator>::PointerSet(const Allocator& allocator)
+    : m_slots(allocator), m_stamps(typename Stamps::allocator_type(allocator)), m_stamp(1), m_size(0) {}
+
+template <typename P, typename Allocator>
+std::size_t PointerSet<P, Allocator>::hash(P pointer) const {
+  std::uint64_t h = reinterpret_cast<std::uintptr_t>(pointer);
+  h ^= h >> 29;
+  h *= 0x9E3779B97F4A7C15ull;  // nodes are aligned, mix the high bits back down
+  return std::size_t(h ^ (h >> 32)) & (m_slots.size() - 1);
+}
+
+template <typename P, typename Allocator>
+bool PointerSet<P, Allocator>::insert(P pointer) {
+  if (2 * (m_size + 1) > m_slots.size()) rehash(std::max<std::size_t>(16, 2 * m_slots.size()));
+  std::size_t mask = m_slots.size() - 1;
+  for (std::size_t i = hash(pointer);; i = (i + 1) & mask) {
+    if (m_stamps[i] != m_stamp) {
+      m_stamps[i] = m_stamp;
+      m_slots[i] = pointer;
+      ++m_size;
+      return true;
+    }
+    if (m_slots[i] == pointer) return false;
+  }
+}
+
+template <typename P, typename Allocator>
+bool PointerSet<P, Allocator>::contains(P pointer) const {
+  if (m_size == 0) return false;
+  std::size_t mask = m_slots.size() - 1;
+  for (std::size_t i = hash(pointer);; i = (i + 1) & mask) {
+    if (m_stamps[i] != m_stamp) return false;
+    if (m_slots[i] == pointer) return true;
+  }
+}
+
+template <typename P, typename Allocator>
+void PointerSet<P, Allocator>::clear() {
+  m_size = 0;
+  if (++m_stamp == 0) {  // the stamps have wrapped around
+    std::fill(m_stamps.begin(), m_stamps.end(), 0);
+    m_stamp = 1;
+  }
+}
+
+template <typename P, typename Allocator>
+void PointerSet<P, Allocator>::reserve(std::size_t count) {
+  std::size_t capacity = 16;
+  while (capacity < 2 * count)
+    capacity *= 2;
+  if (capacity > m_slots.size()) rehash(capacity);
+}
+
+/**
+ move the pointers to a larger table
+ @param std::size_t capacity - a power of 2
+ @return void
+ */
+template <typename P, typename Allocator>
+void PointerSet<P, Allocator>::rehash(std::size_t capacity) {
+  std::vector<P, Allocator> slots(capacity, P(), m_slots.get_allocator());
+  Stamps stamps(capacity, 0, m_stamps.get_allocator());
+  slots.swap(m_slots);
+  stamps.swap(m_stamps);
+  unsigned stamp = m_stamp;
+  m_stamp = 1;
+  m_size = 0;
+  for (std::size_t i = 0; i < slots.size(); ++i)
+    if (stamps[i] == stamp) insert(slots[i]);
+}
+}
+
+#endif /* PointerSet_h */
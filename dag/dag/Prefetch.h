@@ -0,0 +1,23 @@
+#ifndef DAG_PREFETCH_H
+#define DAG_PREFETCH_H
+/** @file Prefetch.h
+ *
+ *  @brief prefetch() asks the processor to start loading an address into the cache
+ *
+ *   Used by the searches to load the links and visited marks of the nodes a few places ahead in their queue,
+ *   so that the loads overlap instead of each one stalling the search. Nothing is done on compilers without
+ *   __builtin_prefetch.
+ */
+
+namespace DAG {
+/// start loading the cache line holding the address (for reading, to be kept in all cache levels)
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address, 0, 3);
+#else
+  (void)address;
+#endif
+}
+}
+
+#endif /* Prefetch_h */
@@ -0,0 +1,209 @@
+#ifndef DAG_REACHABILITYINDEX_H
+#define DAG_REACHABILITYINDEX_H
+/** @class   DAG::ReachabilityIndex
+ *
+ *  @brief ReachabilityIndex answers "is node A an ancestor of node B" without traversing the graph
+ *
+ *   The index is built once for a frozen graph (CompactGraph) using interval labels (GRAIL):
+ *    - each of a few randomised depth first searches gives every node an interval [low, post] such that if A
+ *      reaches B then the interval of B lies inside the interval of A. So if one of the intervals of B is not
+ *      inside the interval of A, A does not reach B.
+ *    - the topological layer of each node (A can only reach B if A is in an earlier layer)
+ *    - the pre-order interval of the first search tree: if B is in the subtree of A then A reaches B.
+ *   Most queries are answered by these tests in constant time. The remaining ones fall back to a depth first
+ *   search from A that is pruned by the same tests (and stops as soon as B is in the subtree of a node found).
+ *
+ *   The memory used is (2 * labelings + 4) * 4 bytes per node. Queries use internal scratch space, so one
+ *   index must not be queried from several threads at the same time.
+ *
+ *  Example usage:
+ *
+ DAG::CompactGraph<INode> graph(nodes);
+ DAG::ReachabilityIndex<INode> index;
+ index.build(graph);
+ if (index.reaches(&n0, &n4)) std::cout << "0 is an ancestor of 4" << std::endl;
+ *
+ */
+
+#include "CompactGraph.h"
+#include "TopologicalSort.h"
+#include <algorithm>
+#include <random>
+
+namespace DAG {
+/// ReachabilityIndex gives near constant time ancestor/descendant queries on a frozen graph
+template <typename N>  /// N is the Node
+class ReachabilityIndex {
+public:
+  typedef typename CompactGraph<N>::Index Index;
+
+  /// labelings is the number of random interval labels per node (more labels, fewer fallback searches)
+  explicit ReachabilityIndex(unsigned labelings = 3, unsigned seed = 1);
+  /// build the index, returns false (and builds nothing) if the graph has a cycle
+  bool build(const CompactGraph<N>& graph);
+  /// true if there is a path from a to b following child links (a node reaches itself)
+  bool reaches(Index a, Index b);
+  bool reaches(const N* a, const N* b) { return reaches(m_graph->index(a), m_graph->index(b)); }
+  bool isAncestor(const N* ancestor, const N* node) { return reaches(ancestor, node); }
+  bool isDescendant(const N* descendant, const N* node) { return reaches(node, descendant); }
+  /// memory used by the labels in bytes
+  std::size_t memory() const;
+  /// number of queries that needed a fallback search (for tuning the number of labelings)
+  std::size_t fallbacks() const { return m_fallbacks; }
+
+private:
+  unsigned m_labelings;
+  std::mt19937 m_random;
+  const CompactGraph<N>* m_graph;
+  std::vector<Index> m_layer;     ///< topological layer of each node
+  std::vector<Index> m_low;       ///< lowest post-order rank below each node, m_labelings values per node
+  std::vector<Index> m_post;      ///< post-order rank of each node, m_labelings values per node
+  std::vector<Index> m_pre;       ///< pre-order rank in the first search tree
+  std::vector<Index> m_subtree;   ///< size of the subtree in the first search tree
+  std::vector<Index> m_visited;   ///< query stamp of each node (avoids clearing between queries)
+  Index m_stamp;
+  std::vector<Index> m_stack;
+  std::size_t m_fallbacks;
+
+  void label(unsigned labeling, const std::vector<Index>& roots);
+  bool inside(Index a, Index b) const;  ///< the intervals of b are all inside those of a
+  /// b is in the subtree of a in the first search tree (so a reaches b)
+  bool inTree(Index a, Index b) const { return m_pre[b] >= m_pre[a] && m_pre[b] < m_pre[a] + m_subtree[a]; }
+};
+
+/// Constructor
+template <typename N>
+ReachabilityIndex<N>::ReachabilityIndex(unsigned labelings, unsigned seed)
+    : m_labelings(std::max(labelings, 1u)), m_random(seed), m_graph(nullptr), m_stamp(0), m_fallbacks(0) {}
+
+/**
+ build the labels of every node of a graph
+ @param const CompactGraph<N>& graph - the graph must stay alive and unchanged while the index is used
+ @return bool - false if the graph has a cycle
+ */
+template <typename N>
+bool ReachabilityIndex<N>::build(const CompactGraph<N>& graph) {
+  TopologicalSort<N> topo;
+  if (!topo.sort(graph)) return false;
+  m_graph = &graph;
+  std::size_t size = graph.size();
+  m_layer.resize(size);
+  for (Index i = 0; i < size; ++i)
+    m_layer[i] = topo.layer(i);
+
+  std::size_t rootCount = topo.layers() > 0 ? topo.layerOffsets()[1] : 0;  // layer 0 holds the roots
+  std::vector<Index> roots(topo.indexOrder().begin(), topo.indexOrder().begin() + rootCount);
+  m_low.resize(size * m_labelings);
+  m_post.resize(size * m_labelings);
+  m_pre.resize(size);
+  m_subtree.resize(size);
+  for (unsigned labeling = 0; labeling < m_labelings; ++labeling) {
+    std::shuffle(roots.begin(), roots.end(), m_random);
+    label(labeling, roots);
+  }
+  m_visited.assign(size, 0);
+  m_stamp = 0;
+  m_fallbacks = 0;
+  return true;
+}
+
+/**
+ one randomised depth first search giving the post-order intervals (and for the first one the pre-order)
+ @param unsigned labeling - which of the labels is being made
+ @param const std::vector<Index>& roots - the nodes without parents, in the order they are to be searched
+ @return void
+ */
+template <typename N>
+void ReachabilityIndex<N>::label(unsigned labeling, const std::vector<Index>& roots) {
+  const CompactGraph<N>& graph = *m_graph;
+  std::size_t size = graph.size();
+  std::vector<bool> visited(size, false);
+  struct Frame {
+    Index node;
+    Index start;  ///< children are visited starting from a random one
+    Index next;   ///< how many children have been looked at
+  };
+  std::vector<Frame> stack;
+  Index post = 0;
+  Index pre = 0;
+  for (Index root : roots) {
+    visited[root] = true;
+    stack.push_back(Frame{root, Index(m_random()), 0});
+    if (labeling == 0) m_pre[root] = pre++;
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      auto children = graph.children(frame.node);
+      if (frame.next < children.size()) {
+        Index child = children[(frame.start + frame.next++) % children.size()];
+        if (!visited[child]) {
+          visited[child] = true;
+          if (labeling == 0) m_pre[child] = pre++;
+          stack.push_back(Frame{child, Index(m_random()), 0});  // NB frame is invalid after this
+        }
+        continue;
+      }
+      // all children are done: the interval starts at the lowest rank found below this node
+      Index node = frame.node;
+      Index low = post;
+      for (Index child : children)
+        low = std::min(low, m_low[child * m_labelings + labeling]);
+      m_low[node * m_labelings + labeling] = low;
+      m_post[node * m_labelings + labeling] = post++;
+      if (labeling == 0) m_subtree[node] = pre - m_pre[node];
+      stack.pop_back();
+    }
+  }
+}
+
+template <typename N>
+bool ReachabilityIndex<N>::inside(Index a, Index b) const {
+  const Index* lowA = &m_low[a * m_labelings];
+  const Index* lowB = &m_low[b * m_labelings];
+  const Index* postA = &m_post[a * m_labelings];
+  const Index* postB = &m_post[b * m_labelings];
+  for (unsigned i = 0; i < m_labelings; ++i)
+    if (lowB[i] < lowA[i] || postB[i] > postA[i]) return false;
+  return true;
+}
+
+/**
+ does a reach b
+ @param Index a - CompactGraph index of the possible ancestor
+ @param Index b - CompactGraph index of the possible descendant
+ @return bool - true if b is a descendant of a (or a == b)
+ */
+template <typename N>
+bool ReachabilityIndex<N>::reaches(Index a, Index b) {
+  if (a == CompactGraph<N>::npos || b == CompactGraph<N>::npos) return false;
+  if (a == b) return true;
+  if (m_layer[a] >= m_layer[b] || !inside(a, b)) return false;
+  if (inTree(a, b)) return true;
+
+  // fallback: depth first search from a, pruned by the labels
+  ++m_fallbacks;
+  if (++m_stamp == 0) {  // the stamps have wrapped around
+    std::fill(m_visited.begin(), m_visited.end(), 0);
+    m_stamp = 1;
+  }
+  m_stack.assign(1, a);
+  while (!m_stack.empty()) {
+    Index node = m_stack.back();
+    m_stack.pop_back();
+    for (Index child : m_graph->children(node)) {
+      if (child == b || inTree(child, b)) return true;
+      if (m_visited[child] == m_stamp || m_layer[child] >= m_layer[b] || !inside(child, b)) continue;
+      m_visited[child] = m_stamp;
+      m_stack.push_back(child);
+    }
+  }
+  return false;
+}
+
+template <typename N>
+std::size_t ReachabilityIndex<N>::memory() const {
+  return sizeof(Index) * (m_layer.size() + m_low.size() + m_post.size() + m_pre.size() + m_subtree.size() +
+                          m_visited.size());
+}
+}
+
+#endif /* ReachabilityIndex_h */
@@ -0,0 +1,142 @@
+#ifndef DAG_REORDERING_H
+#define DAG_REORDERING_H
+/** @class   DAG::Reordering
+ *
+ *  @brief Reordering computes a renumbering of the nodes of a CompactGraph that improves memory locality
+ *
+ *   When the nodes are indexed in the order they come from the event store, neighbours have unrelated indices
+ *   and every step of a search touches a new cache line of the offsets, visited marks and NodeColumns. The
+ *   orderings below give linked nodes nearby indices:
+ *    - BFS: the order of an undirected breadth first search of each connected block
+ *    - RCM: reverse Cuthill-McKee, a breadth first search from a node of smallest degree that visits the
+ *      neighbours of each node by increasing degree, reversed (keeps the links close to the diagonal)
+ *    - HUBS: hub sorting, the nodes of more than average degree are moved to the front by decreasing degree and
+ *      the other nodes keep their order
+ *   The permutation is returned (order()[new index] = old index) and applied with CompactGraph::permute and
+ *   NodeColumn::permute. EdgeColumns follow the links with the slot permutations given by CompactGraph::permute.
+ *   Indices kept from before the renumbering can be translated with newIndex().
+ *
+ *  Example usage:
+ *
+ DAG::CompactGraph<INode> graph(nodes);
+ DAG::NodeColumn<double> energy(graph, [](const INode* node) { return node->value().energy; });
+ DAG::EdgeColumn<int> linkType(graph, [](const INode* parent, const INode* child) { return type(parent, child); });
+ DAG::Reordering<INode> reordering;
+ const auto& order = reordering.compute(graph, DAG::Ordering::RCM);
+ std::vector<unsigned> childSlots, parentSlots;
+ graph.permute(order, childSlots, parentSlots);
+ energy.permute(order);
+ linkType.permute(childSlots, parentSlots);
+ *
+ */
+
+#include "CompactGraph.h"
+#include <algorithm>
+#include <vector>
+
+namespace DAG {
+/// the renumberings computed by Reordering
+enum class Ordering { BFS, RCM, HUBS };
+
+/// Reordering computes locality improving permutations of the nodes of a CompactGraph
+template <typename N>  /// N is the Node
+class Reordering {
+public:
+  typedef typename CompactGraph<N>::Index Index;
+
+  /**
+   compute a renumbering of the nodes of the graph
+   @param const CompactGraph<N>& graph - the graph (it is not changed)
+   @param Ordering ordering - BFS, RCM or HUBS
+   @return const std::vector<Index>& - the old index of each new index
+   */
+  const std::vector<Index>& compute(const CompactGraph<N>& graph, Ordering ordering);
+  /// the last permutation computed, order()[new index] is the old index
+  const std::vector<Index>& order() const { return m_order; }
+  /// the inverse permutation, newIndex()[old index] is the new index
+  const std::vector<Index>& newIndex() const { return m_newIndex; }
+
+private:
+  std::vector<Index> m_order;
+  std::vector<Index> m_newIndex;
+  std::vector<Index> m_degree;
+  std::vector<char> m_reached;
+
+  /// undirected breadth first search from each node not yet reached (starts taken in the given order)
+  void search(const CompactGraph<N>& graph, const std::vector<Index>& starts, bool byDegree);
+  void hubs(const CompactGraph<N>& graph);
+};
+
+template <typename N>
+const std::vector<typename Reordering<N>::Index>& Reordering<N>::compute(const CompactGraph<N>& graph,
+                                                                         Ordering ordering) {
+  const Index size = graph.size();
+  m_degree.resize(size);
+  for (Index i = 0; i < size; ++i)
+    m_degree[i] = graph.children(i).size() + graph.parents(i).size();
+  std::vector<Index> starts(size);
+  for (Index i = 0; i < size; ++i)
+    starts[i] = i;
+  if (ordering == Ordering::BFS)
+    search(graph, starts, false);
+  else if (ordering == Ordering::RCM) {
+    // start each block from one of its nodes of smallest degree
+    std::stable_sort(starts.begin(), starts.end(), [this](Index a, Index b) { return m_degree[a] < m_degree[b]; });
+    search(graph, starts, true);
+    std::reverse(m_order.begin(), m_order.end());
+  } else
+    hubs(graph);
+  m_newIndex.resize(size);
+  for (Index k = 0; k < size; ++k)
+    m_newIndex[m_order[k]] = k;
+  return m_order;
+}
+
+/**
+ breadth first numbering of each connected block, the order is also the queue
+ @param const CompactGraph<N>& graph
+ @param const std::vector<Index>& starts - the nodes in the order they are tried as the start of a new block
+ @param bool byDegree - visit the new neighbours of each node by increasing degree (Cuthill-McKee)
+ @return void
+ */
+template <typename N>
+void Reordering<N>::search(const CompactGraph<N>& graph, const std::vector<Index>& starts, bool byDegree) {
+  m_order.clear();
+  m_order.reserve(graph.size());
+  m_reached.assign(graph.size(), 0);
+  for (Index start : starts) {
+    if (m_reached[start]) continue;
+    m_reached[start] = 1;
+    m_order.push_back(start);
+    for (std::size_t k = m_order.size() - 1; k < m_order.size(); ++k) {
+      Index node = m_order[k];
+      std::size_t first = m_order.size();
+      graph.forEachLink(node, VisitType::UNDIRECTED, [this](const CompactLink& link) {
+        if (!m_reached[link.node]) {
+          m_reached[link.node] = 1;
+          m_order.push_back(link.node);
+        }
+      });
+      if (byDegree)
+        std::stable_sort(m_order.begin() + first, m_order.end(),
+                         [this](Index a, Index b) { return m_degree[a] < m_degree[b]; });
+    }
+  }
+}
+
+/// nodes of more than average degree first (largest degree first), then the others in their current order
+template <typename N>
+void Reordering<N>::hubs(const CompactGraph<N>& graph) {
+  const Index size = graph.size();
+  double average = size ? 2. * graph.edges() / size : 0.;
+  m_order.clear();
+  m_order.reserve(size);
+  for (Index i = 0; i < size; ++i)
+    if (m_degree[i] > average) m_order.push_back(i);
+  std::stable_sort(m_order.begin(), m_order.end(), [this](Index a, Index b) { return m_degree[a] > m_degree[b]; });
+  for (Index i = 0; i < size; ++i)
+    if (m_degree[i] <= average) m_order.push_back(i);
+}
+}
+
+#endif /* Reordering_h */
@@ -0,0 +1,126 @@
+#ifndef DAG_THREADPOOL_H
+#define DAG_THREADPOOL_H
+/** @class   DAG::ThreadPool
+ *
+ *  @brief ThreadPool is a fixed set of worker threads used by the parallel graph algorithms
+ *
+ *   Tasks are either submitted one at a time (submit) or a range of work is split into one chunk per
+ *   thread (parallelFor). parallelFor runs the first chunk on the calling thread and returns once every
+ *   chunk is done. parallelFor must not be called from inside a task of the same pool.
+ *
+ *  Example usage:
+ *
+ DAG::ThreadPool pool(4);
+ std::vector<int> counts(1000);
+ pool.parallelFor(counts.size(), [&](std::size_t begin, std::size_t end, unsigned chunk) {
+   for (std::size_t i = begin; i < end; ++i) counts[i] = i;
+ });
+ *
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DAG {
+/// ThreadPool runs tasks on a fixed set of worker threads
+class ThreadPool {
+public:
+  /// the body of a parallelFor is given the range [begin, end) to process and the chunk number
+  typedef std::function<void(std::size_t begin, std::size_t end, unsigned chunk)> RangeTask;
+
+  explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// number of worker threads (also the number of chunks used by parallelFor)
+  unsigned size() const { return m_workers.size(); }
+  /// queue a task, the future becomes ready when it has run
+  std::future<void> submit(std::function<void()> task);
+  /// split [0, count) into at most size() chunks and process them in parallel (blocks until done)
+  void parallelFor(std::size_t count, const RangeTask& body);
+
+private:
+  std::vector<std::thread> m_workers;
+  std::deque<std::packaged_task<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeup;
+  bool m_stop;
+
+  void run();
+};
+
+inline ThreadPool::ThreadPool(unsigned threads) : m_stop(false) {
+  if (threads == 0) threads = 1;  // hardware_concurrency may be unknown
+  for (unsigned i = 0; i < threads; ++i)
+    m_workers.emplace_back(&ThreadPool::run, this);
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wakeup.notify_all();
+  for (auto& worker : m_workers)
+    worker.join();
+}
+
+inline std::future<void> ThreadPool::submit(std::function<void()> task) {
+  std::packaged_task<void()> packaged(std::move(task));
+  std::future<void> result = packaged.get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push_back(std::move(packaged));
+  }
+  m_wakeup.notify_one();
+  return result;
+}
+
+/**
+ process a range of work in parallel
+ @param std::size_t count - the size of the range [0, count)
+ @param const RangeTask& body - called once per chunk with its [begin, end) and chunk number
+ @return void
+ */
+inline void ThreadPool::parallelFor(std::size_t count, const RangeTask& body) {
+  std::size_t chunks = std::min<std::size_t>(size(), count);
+  if (chunks <= 1) {
+    if (count > 0) body(0, count, 0);
+    return;
+  }
+  std::vector<std::future<void>> pending;
+  pending.reserve(chunks - 1);
+  for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+    std::size_t begin = count * chunk / chunks;
+    std::size_t end = count * (chunk + 1) / chunks;
+    pending.push_back(submit([&body, begin, end, chunk] { body(begin, end, chunk); }));
+  }
+  body(0, count / chunks, 0);  // the calling thread does the first chunk
+  for (auto& result : pending)
+    result.get();  // rethrows any exception from the chunk
+}
+
+/// worker thread loop
+inline void ThreadPool::run() {
+  while (true) {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wakeup.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+      if (m_tasks.empty()) return;  // stopping and nothing left to do
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
+}
+
+#endif /* ThreadPool_h */
@@ -0,0 +1,229 @@
+#ifndef DAG_TOPOLOGICALSORT_H
+#define DAG_TOPOLOGICALSORT_H
+/** @class   DAG::TopologicalSort
+ *
+ *  @brief TopologicalSort orders nodes so that every parent comes before its children
+ *
+ *   The order is found with Kahn's algorithm and is split into layers (generations): layer 0 holds the nodes
+ *   without parents and layer k holds the nodes whose parents are all in earlier layers. The nodes inside a
+ *   layer are independent of each other, so work can be scheduled one layer at a time in parallel.
+ *
+ *   When a ThreadPool is given, the in-degrees are computed in parallel and each large layer is peeled
+ *   across the threads (the order of the nodes inside a layer may then vary from run to run).
+ *
+ *   If the graph contains a cycle, the nodes on it (and those after it) can not be ordered: sort() returns
+ *   false, unsorted() gives the nodes that were left over and cycle() one of the cycles.
+ *
+ *  Example usage:
+ *
+ typedef DAG::Node<int> INode;
+ INode n0(0), n1(1), n2(2);
+ n0.addChild(n1);
+ n1.addChild(n2);
+ DAG::TopologicalSort<INode> topo;
+ topo.sort(n0);
+ for (std::size_t layer = 0; layer < topo.layers(); ++layer)
+   for (std::size_t i = topo.layerOffsets()[layer]; i < topo.layerOffsets()[layer + 1]; ++i)
+     std::cout << layer << ": " << topo.order()[i]->value() << std::endl;
+ *
+ */
+
+#include "CompactGraph.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <memory>
+
+namespace DAG {
+/// TopologicalSort produces a layered topological order of a set of nodes
+template <typename N>  /// N is the Node
+class TopologicalSort {
+public:
+  typedef typename CompactGraph<N>::Index Index;
+
+  /// the pool is optional, without it everything runs on the calling thread
+  explicit TopologicalSort(ThreadPool* pool = nullptr);
+  /// sort all nodes linked (undirected) to the start node
+  bool sort(const N& startnode);
+  /// sort a set of nodes, links to nodes outside the set are ignored
+  bool sort(const Nodevector<N>& nodes);
+  /// sort a frozen graph, the graph must stay alive while the results are used
+  bool sort(const CompactGraph<N>& graph);
+
+  /// the sorted nodes, parents before children
+  const Nodevector<N>& order() const { return m_nodeOrder; }
+  /// the same order given as indices of the CompactGraph
+  const std::vector<Index>& indexOrder() const { return m_order; }
+  /// number of layers
+  std::size_t layers() const { return m_layerOffsets.size() - 1; }
+  /// layer k is found at [layerOffsets()[k], layerOffsets()[k+1]) in the order
+  const std::vector<std::size_t>& layerOffsets() const { return m_layerOffsets; }
+  /// the layer of the node with the given CompactGraph index
+  Index layer(Index i) const { return m_layer[i]; }
+  bool hasCycle() const { return m_order.size() < m_graph->size(); }
+  /// the nodes that could not be ordered because they are on or after a cycle
+  Nodevector<N> unsorted() const;
+  /// one of the cycles (each node is a parent of the next, the last is a parent of the first)
+  Nodevector<N> cycle() const;
+  /// the graph that was sorted
+  const CompactGraph<N>& graph() const { return *m_graph; }
+
+  /// layers smaller than this are peeled on the calling thread
+  void setGrainSize(std::size_t grain) { m_grain = grain; }
+
+private:
+  ThreadPool* m_pool;
+  std::size_t m_grain;
+  CompactGraph<N> m_ownGraph;      ///< used when sorting nodes rather than a CompactGraph
+  const CompactGraph<N>* m_graph;  ///< the graph being sorted
+  std::vector<Index> m_order;
+  Nodevector<N> m_nodeOrder;
+  std::vector<std::size_t> m_layerOffsets;
+  std::vector<Index> m_layer;
+  std::unique_ptr<std::atomic<Index>[]> m_inDegree;  ///< number of parents not yet ordered
+  std::size_t m_capacity;                           ///< allocated size of m_inDegree
+  std::vector<std::vector<Index>> m_buffers;        ///< per chunk buffers for the next layer
+
+  void peel(std::size_t begin, std::size_t end, std::vector<Index>& next, Index layer);
+};
+
+/// Constructor
+template <typename N>
+TopologicalSort<N>::TopologicalSort(ThreadPool* pool)
+    : m_pool(pool), m_grain(1024), m_graph(&m_ownGraph), m_layerOffsets(1, 0), m_capacity(0) {}
+
+template <typename N>
+bool TopologicalSort<N>::sort(const N& startnode) {
+  return sort(CompactGraph<N>::connected(startnode));
+}
+
+template <typename N>
+bool TopologicalSort<N>::sort(const Nodevector<N>& nodes) {
+  m_ownGraph.build(nodes);
+  return sort(m_ownGraph);
+}
+
+/**
+ layered topological sort (Kahn's algorithm)
+ @param const CompactGraph<N>& graph - the graph to be sorted
+ @return bool - false if a cycle was found (the order then only contains the nodes that could be sorted)
+ */
+template <typename N>
+bool TopologicalSort<N>::sort(const CompactGraph<N>& graph) {
+  m_graph = &graph;
+  std::size_t size = graph.size();
+  if (m_capacity < size) {
+    m_inDegree.reset(new std::atomic<Index>[size]);
+    m_capacity = size;
+  }
+  m_order.clear();
+  m_order.reserve(size);
+  m_layer.assign(size, 0);
+  m_layerOffsets.assign(1, 0);
+  unsigned chunks = m_pool ? m_pool->size() : 1;
+  m_buffers.resize(chunks);
+
+  // in-degrees and nodes without parents
+  auto countParents = [this, &graph](std::size_t begin, std::size_t end, unsigned chunk) {
+    std::vector<Index>& roots = m_buffers[chunk];
+    roots.clear();
+    for (std::size_t i = begin; i < end; ++i) {
+      Index parents = graph.parentOffsets()[i + 1] - graph.parentOffsets()[i];
+      m_inDegree[i].store(parents, std::memory_order_relaxed);
+      if (parents == 0) roots.push_back(i);
+    }
+  };
+  if (m_pool && size >= m_grain)
+    m_pool->parallelFor(size, countParents);
+  else
+    countParents(0, size, 0);
+  for (auto& buffer : m_buffers) {
+    m_order.insert(m_order.end(), buffer.begin(), buffer.end());
+    buffer.clear();
+  }
+
+  // peel one layer at a time
+  std::size_t begin = 0;
+  for (Index layer = 1; begin < m_order.size(); ++layer) {
+    std::size_t end = m_order.size();
+    m_layerOffsets.push_back(end);
+    if (m_pool && end - begin >= m_grain) {
+      m_pool->parallelFor(end - begin, [this, begin, layer](std::size_t first, std::size_t last, unsigned chunk) {
+        peel(begin + first, begin + last, m_buffers[chunk], layer);
+      });
+    } else {
+      peel(begin, end, m_buffers[0], layer);
+    }
+    for (auto& buffer : m_buffers) {
+      m_order.insert(m_order.end(), buffer.begin(), buffer.end());
+      buffer.clear();
+    }
+    begin = end;
+  }
+
+  m_nodeOrder.clear();
+  m_nodeOrder.reserve(m_order.size());
+  for (Index i : m_order)
+    m_nodeOrder.push_back(graph.node(i));
+  return !hasCycle();
+}
+
+/**
+ remove the links from a range of ordered nodes to their children
+ @param std::size_t begin, end - range of m_order to process
+ @param std::vector<Index>& next - collects the children that have no parents left
+ @param Index layer - the layer of those children
+ @return void
+ */
+template <typename N>
+void TopologicalSort<N>::peel(std::size_t begin, std::size_t end, std::vector<Index>& next, Index layer) {
+  for (std::size_t i = begin; i < end; ++i) {
+    for (Index child : m_graph->children(m_order[i])) {
+      if (m_inDegree[child].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_layer[child] = layer;
+        next.push_back(child);
+      }
+    }
+  }
+}
+
+template <typename N>
+Nodevector<N> TopologicalSort<N>::unsorted() const {
+  Nodevector<N> result;
+  for (Index i = 0; i < m_graph->size(); ++i)
+    if (m_inDegree[i].load() > 0) result.push_back(m_graph->node(i));
+  return result;
+}
+
+/**
+ find a cycle among the unsorted nodes: each of them has at least one unsorted parent, so walking from
+ parent to parent must eventually come back to a node already seen
+ @return Nodevector<N> - the nodes of the cycle, empty if there is no cycle
+ */
+template <typename N>
+Nodevector<N> TopologicalSort<N>::cycle() const {
+  Nodevector<N> result;
+  if (!hasCycle()) return result;
+  const Index unseen = CompactGraph<N>::npos;
+  std::vector<Index> step(m_graph->size(), unseen);  // position of each node along the walk
+  std::vector<Index> walk;
+  Index current = 0;
+  while (m_inDegree[current].load() == 0)
+    ++current;
+  while (step[current] == unseen) {
+    step[current] = walk.size();
+    walk.push_back(current);
+    for (Index parent : m_graph->parents(current)) {
+      if (m_inDegree[parent].load() > 0) {
+        current = parent;
+        break;
+      }
+    }
+  }
+  // the walk went from child to parent, so reverse it to list the cycle from parent to child
+  for (std::size_t i = walk.size(); i > step[current]; --i)
+    result.push_back(m_graph->node(walk[i - 1]));
+  return result;
+}
+}
+
+#endif /* TopologicalSort_h */
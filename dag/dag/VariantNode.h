@@ -0,0 +1,83 @@
+#ifndef DAG_VARIANTNODE_H
+#define DAG_VARIANTNODE_H
+/** @file VariantNode.h
+ *
+ *  @brief Nodes holding one of a fixed list of payload types, without a heap allocation per node
+ *
+ *   Node<boost::any> (see DAG_example_boostany.cpp) allocates every payload on the heap and each read compares
+ *   typeid. A VariantNode<Types...> is a Node<std::variant<Types...>>: the payload is stored inside the node and
+ *   carries a small type tag (its position in Types), so reading it is a switch on the tag.
+ *
+ *   typeTag() gives the tag of a node and tagOf<T, Variant>() the tag of a type, payloadIf<T>() returns a
+ *   pointer to the payload if it has type T and visitPayload() calls the matching overload of a visitor, which
+ *   can be built from lambdas with Overloaded.
+ *
+ *  Example usage:
+ *
+ typedef DAG::VariantNode<int, Middle> VNode;
+ VNode n0(0), n1(Middle(1));
+ n0.addChild(n1);
+ DAG::BFSVisitor<VNode> bfs;
+ for (auto node : bfs.traverseChildren(n0))
+   DAG::visitPayload(*node, DAG::Overloaded{[](int i) { std::cout << "Integer: " << i << std::endl; },
+                                             [](const Middle& m) { m.Write(); }});
+ *
+ */
+
+#include "DirectedAcyclicGraph.h"
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace DAG {
+/// a Node whose payload is one of Types
+template <typename... Types>
+using VariantNode = Node<std::variant<Types...>>;
+
+/// builds a visitor from several lambdas (one per payload type)
+template <typename... Fs>
+struct Overloaded : Fs... {
+  using Fs::operator()...;
+};
+template <typename... Fs>
+Overloaded(Fs...)->Overloaded<Fs...>;
+
+/// the tag of type T in the variant V (the number of types of V if T is not one of them)
+template <typename T, typename V>
+struct VariantTag;
+template <typename T, typename... Types>
+struct VariantTag<T, std::variant<Types...>> {
+  static constexpr std::size_t find() {
+    constexpr bool same[] = {std::is_same<T, Types>::value...};
+    std::size_t i = 0;
+    while (i < sizeof...(Types) && !same[i])
+      ++i;
+    return i;
+  }
+  static constexpr std::size_t value = find();
+};
+template <typename T, typename V>
+constexpr std::size_t tagOf() {
+  return VariantTag<T, V>::value;
+}
+
+/// type tag of the payload of a node
+template <typename A, typename... Types>
+std::size_t typeTag(const Node<std::variant<Types...>, A>& node) {
+  return node.value().index();
+}
+
+/// the payload if it is of type T, otherwise nullptr
+template <typename T, typename A, typename... Types>
+const T* payloadIf(const Node<std::variant<Types...>, A>& node) {
+  return std::get_if<T>(&node.value());
+}
+
+/// call the overload of the visitor that matches the type of the payload
+template <typename F, typename A, typename... Types>
+decltype(auto) visitPayload(const Node<std::variant<Types...>, A>& node, F&& visitor) {
+  return std::visit(std::forward<F>(visitor), node.value());
+}
+}
+
+#endif /* VariantNode_h */
@@ -0,0 +1,169 @@
+#ifndef DAG_WEIGHTEDPATHS_H
+#define DAG_WEIGHTEDPATHS_H
+/** @class   DAG::WeightedPaths
+ *
+ *  @brief WeightedPaths finds the shortest or longest (critical) weighted paths in a DAG
+ *
+ *   Because the graph is acyclic, paths can be found in linear time by processing the nodes in topological
+ *   order: when a node is reached all of its parents are final, so its distance is the best over its parents of
+ *   (parent distance + link weight). This works for negative weights too and gives the longest paths as easily
+ *   as the shortest ones (no Dijkstra needed).
+ *
+ *   The link weights are those stored in the CompactGraph (each link counts 1 if the graph has no weights).
+ *   Several sources can be given at once, the distance of a node is then the best over all the sources. When a
+ *   ThreadPool is given each large topological layer is processed in parallel (the nodes of a layer only read
+ *   the distances of earlier layers).
+ *
+ *  Example usage:
+ *
+ DAG::CompactGraph<INode> graph(nodes, [](const INode* parent, const INode* child) {
+   return linkDistance(parent, child);
+ });
+ DAG::WeightedPaths<INode> paths;
+ paths.build(graph);
+ paths.shortest(graph.index(&n0));
+ double d = paths.distances()[graph.index(&n8)];
+ auto route = paths.path(graph.index(&n8));
+ *
+ */
+
+#include "CompactGraph.h"
+#include "ThreadPool.h"
+#include "TopologicalSort.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace DAG {
+/// WeightedPaths computes single or multi source shortest and longest paths over a topological order
+template <typename N>  /// N is the Node
+class WeightedPaths {
+public:
+  typedef typename CompactGraph<N>::Index Index;
+
+  /// the pool is optional, without it everything runs on the calling thread
+  explicit WeightedPaths(ThreadPool* pool = nullptr);
+  /// sort the graph, returns false if it has a cycle
+  bool build(const CompactGraph<N>& graph);
+  /// shortest paths from one or several sources
+  void shortest(Index source) { run(std::vector<Index>(1, source), false); }
+  void shortest(const std::vector<Index>& sources) { run(sources, false); }
+  /// longest paths from one or several sources
+  void longest(Index source) { run(std::vector<Index>(1, source), true); }
+  void longest(const std::vector<Index>& sources) { run(sources, true); }
+  /// the longest path anywhere in the graph, returns the node where it ends (use path() to get it)
+  Index criticalPath();
+
+  /// distance of each node from the sources (+infinity/-infinity for shortest/longest if it is not reached)
+  const std::vector<double>& distances() const { return m_distance; }
+  /// the node before each node on its best path (npos for the sources and the nodes not reached)
+  const std::vector<Index>& predecessors() const { return m_predecessor; }
+  bool reached(Index i) const { return std::abs(m_distance[i]) != std::numeric_limits<double>::infinity(); }
+  /// the best path from a source to the target (empty if the target is not reached)
+  Nodevector<N> path(Index target) const;
+
+  /// layers smaller than this are processed on the calling thread
+  void setGrainSize(std::size_t grain) { m_grain = grain; }
+
+private:
+  ThreadPool* m_pool;
+  std::size_t m_grain;
+  const CompactGraph<N>* m_graph;
+  TopologicalSort<N> m_sort;
+  std::vector<double> m_distance;
+  std::vector<Index> m_predecessor;
+
+  void run(const std::vector<Index>& sources, bool longest);
+  void relax(std::size_t begin, std::size_t end, bool longest);
+};
+
+/// Constructor
+template <typename N>
+WeightedPaths<N>::WeightedPaths(ThreadPool* pool) : m_pool(pool), m_grain(1024), m_graph(nullptr) {}
+
+template <typename N>
+bool WeightedPaths<N>::build(const CompactGraph<N>& graph) {
+  m_graph = &graph;
+  return m_sort.sort(graph);
+}
+
+/**
+ best distances from the sources, processing the topological layers in order
+ @param const std::vector<Index>& sources - nodes that start at distance 0
+ @param bool longest - find the longest rather than the shortest paths
+ @return void
+ */
+template <typename N>
+void WeightedPaths<N>::run(const std::vector<Index>& sources, bool longest) {
+  const double infinity = std::numeric_limits<double>::infinity();
+  const double unreached = longest ? -infinity : infinity;
+  m_distance.assign(m_graph->size(), unreached);
+  m_predecessor.assign(m_graph->size(), CompactGraph<N>::npos);
+  for (Index source : sources)
+    m_distance[source] = 0;
+
+  const auto& offsets = m_sort.layerOffsets();
+  for (std::size_t layer = 0; layer < m_sort.layers(); ++layer) {
+    std::size_t begin = offsets[layer];
+    std::size_t end = offsets[layer + 1];
+    if (m_pool && end - begin >= m_grain)
+      m_pool->parallelFor(end - begin, [this, begin, longest](std::size_t first, std::size_t last, unsigned) {
+        relax(begin + first, begin + last, longest);
+      });
+    else
+      relax(begin, end, longest);
+  }
+}
+
+/// each node takes the best of its parents (which are all in earlier layers)
+template <typename N>
+void WeightedPaths<N>::relax(std::size_t begin, std::size_t end, bool longest) {
+  const bool weighted = m_graph->weighted();
+  for (std::size_t k = begin; k < end; ++k) {
+    Index node = m_sort.indexOrder()[k];
+    auto parents = m_graph->parents(node);
+    const double* weights = weighted ? m_graph->parentWeights(node).begin() : nullptr;
+    double best = m_distance[node];
+    Index previous = m_predecessor[node];
+    for (std::size_t j = 0; j < parents.size(); ++j) {
+      double from = m_distance[parents[j]];
+      if (std::abs(from) == std::numeric_limits<double>::infinity()) continue;  // parent not reached
+      double distance = from + (weights ? weights[j] : 1.);
+      if (longest ? distance > best : distance < best) {
+        best = distance;
+        previous = parents[j];
+      }
+    }
+    m_distance[node] = best;
+    m_predecessor[node] = previous;
+  }
+}
+
+/**
+ longest path anywhere in the graph (every node is a possible start)
+ @return Index - the last node of the critical path (npos for an empty graph)
+ */
+template <typename N>
+typename WeightedPaths<N>::Index WeightedPaths<N>::criticalPath() {
+  std::vector<Index> all(m_graph->size());
+  for (Index i = 0; i < all.size(); ++i)
+    all[i] = i;
+  run(all, true);
+  Index end = CompactGraph<N>::npos;
+  for (Index i = 0; i < all.size(); ++i)
+    if (end == CompactGraph<N>::npos || m_distance[i] > m_distance[end]) end = i;
+  return end;
+}
+
+template <typename N>
+Nodevector<N> WeightedPaths<N>::path(Index target) const {
+  Nodevector<N> result;
+  if (!reached(target)) return result;
+  for (Index i = target; i != CompactGraph<N>::npos; i = m_predecessor[i])
+    result.push_back(m_graph->node(i));
+  std::reverse(result.begin(), result.end());
+  return result;
+}
+}
+
+#endif /* WeightedPaths_h */
@@ -0,0 +1,62 @@
+//
+//  DAG_example_variant.cpp
+//
+//  The boost::any example (DAG_example_boostany.cpp) written with a VariantNode: the items are stored inside
+//  the nodes (no allocation per node) and the type is found from a tag instead of typeid.
+//
+#include "dag/VariantNode.h"
+#include <string>
+
+class Middle {  // example class
+public:
+  Middle(int i) : m_val(i){};
+  void Write() const { std::cout << "middle: " + std::to_string(m_val) << std::endl; };
+  int m_val;
+};
+
+int main() {
+  /*  Construct an example polytree
+   Here 0 and 8 are top level parents
+   0 has children 1, 2, 3 etc (see DAG_example_boostany.cpp)
+   */
+  typedef DAG::VariantNode<int, Middle> VNode;
+
+  // an integer or a Middle goes directly inside each node
+  VNode n0(0);
+  VNode n1(Middle(1));
+  VNode n2(Middle(2));
+  VNode n3(Middle(3));
+  VNode n4(Middle(4));
+  VNode n5(Middle(5));
+  VNode n6(Middle(6));
+  VNode n7(Middle(7));
+  VNode n8(8);
+
+  n0.addChild(n1);
+  n0.addChild(n2);
+  n0.addChild(n3);
+  n1.addChild(n4);
+  n1.addChild(n5);
+  n1.addChild(n6);
+  n7.addChild(n8);
+  n7.addChild(n4);
+  n3.addChild(n6);
+
+  DAG::BFSVisitor<VNode> bfs;
+
+  std::cout << std::endl;
+  std::cout << "VARIANT TRAVERSE UNDIRECTED (starting from 0)  " << std::endl;
+  auto print = DAG::Overloaded{[](int i) { std::cout << "Integer: " << i << std::endl; },
+                               [](const Middle& middle) { middle.Write(); }};
+  for (auto n : bfs.traverseUndirected(n0))
+    DAG::visitPayload(*n, print);
+
+  // or test the tag directly
+  std::size_t middles = 0;
+  for (auto n : bfs.traverseUndirected(n0))
+    if (DAG::typeTag(*n) == DAG::tagOf<Middle, VNode::value_type>()) ++middles;
+  std::cout << middles << " Middle items" << std::endl;
+
+  std::cout << "END" << std::endl;
+  return 0;
+}
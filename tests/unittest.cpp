@@ -1,13 +1,110 @@
 // STL
 
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
 #include <vector>
 #include <algorithm>
+#include <numeric>
+#include <random>
 #include "dag/DirectedAcyclicGraph.h"
 #include "dag/FloodFill.h"
+#include "dag/DynamicConnectivity.h"
+#include "dag/TopologicalSort.h"
+#include "dag/DynamicTopologicalOrder.h"
+#include "dag/ReachabilityIndex.h"
+#include "dag/CommonAncestors.h"
+#include "dag/BidirectionalSearch.h"
+#include "dag/WeightedPaths.h"
+#include "dag/CompactBFS.h"
+#include "dag/LayeredGraph.h"
+#include "dag/EventBatch.h"
+#include "dag/GraphBFS.h"
+#include "dag/GraphFloodFill.h"
+#include "dag/PmrGraph.h"
+#include "dag/Reordering.h"
+#include "dag/VariantNode.h"
 // catch
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
+// Test hook: every heap allocation made by this program goes through these replacements and is counted, so
+// a test can check that some code does not allocate (compare allocationCount() before and after).
+static std::atomic<std::size_t> g_allocations(0);
+std::size_t allocationCount() { return g_allocations.load(); }
+
+// every form of operator new and delete is replaced, so that each delete matches the new it is given memory from
+static void* countedAllocation(std::size_t size, std::size_t alignment) noexcept {
+  ++g_allocations;
+  if (alignment <= alignof(std::max_align_t)) return std::malloc(size ? size : 1);
+  return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);  // a multiple of alignment
+}
+static void* countedAllocationOrThrow(std::size_t size, std::size_t alignment) {
+  if (void* memory = countedAllocation(size, alignment)) return memory;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedAllocationOrThrow(size, 0); }
+void* operator new[](std::size_t size) { return countedAllocationOrThrow(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocation(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocation(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return countedAllocationOrThrow(size, std::size_t(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return countedAllocationOrThrow(size, std::size_t(alignment));
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return countedAllocation(size, std::size_t(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return countedAllocation(size, std::size_t(alignment));
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { std::free(memory); }
+
+// links (parent, child) of the example graph of the DAG test, used by most of the tests below
+const std::vector<std::pair<int, int>> exampleLinks{{0, 1}, {0, 2}, {0, 3}, {1, 4}, {1, 5},
+                                                    {1, 6}, {7, 8}, {7, 4}, {3, 6}};
+
+/// link nodes 0..8 of a container of nodes as in the DAG test
+template <typename Nodes>
+void linkExample(Nodes& nodes) {
+  for (auto& link : exampleLinks)
+    nodes[link.first].addChild(nodes[link.second]);
+}
+
+/// the nodes 0..8 of the example graph, linked
+template <typename N>
+std::vector<N> exampleGraph() {
+  std::vector<N> nodes;
+  nodes.reserve(9);
+  for (int i = 0; i < 9; ++i)
+    nodes.emplace_back(i);
+  linkExample(nodes);
+  return nodes;
+}
+
+/// pointers to the nodes of a container, in order
+template <typename N>
+DAG::Nodevector<N> pointers(std::vector<N>& nodes) {
+  DAG::Nodevector<N> all;
+  for (auto& node : nodes)
+    all.push_back(&node);
+  return all;
+}
+
 
 TEST_CASE("DAG") {  /// ID test
   typedef DAG::Node<const int> INode;
@@ -106,4 +203,1239 @@ TEST_CASE("FloodFill") {
   
 }
 
+TEST_CASE("RemoveLinks") {
+  typedef DAG::Node<int> INode;
+  INode n0(0);
+  INode n1(1);
+  INode n2(2);
+  n0.addChild(n1);
+  n0.addChild(n2);
+  n1.addChild(n2);
+
+  n0.removeChild(n1);
+  REQUIRE(n0.children().size() == 1);
+  REQUIRE(n1.parents().size() == 0);
+
+  n2.detach();
+  REQUIRE(n0.children().size() == 0);
+  REQUIRE(n1.children().size() == 0);
+  REQUIRE(n2.parents().size() == 0);
+}
+
+TEST_CASE("DynamicConnectivity") {
+  typedef DAG::Node<int> INode;
+  // chain 0 - 1 - 2 - 3 plus 4 linked to 2
+  std::vector<INode> nodes;
+  for (int i = 0; i < 5; ++i)
+    nodes.emplace_back(i);
+  DAG::DynamicConnectivity<INode> blocks;
+  for (auto& n : nodes)
+    blocks.addNode(n);
+  REQUIRE(blocks.blocks() == 5);
+
+  blocks.addChild(nodes[0], nodes[1]);
+  blocks.addChild(nodes[1], nodes[2]);
+  blocks.addChild(nodes[2], nodes[3]);
+  blocks.addChild(nodes[4], nodes[2]);
+  blocks.addChild(nodes[0], nodes[2]);
+  REQUIRE(blocks.blocks() == 1);
+
+  // 0 is still linked to 2 so no split
+  REQUIRE(!blocks.removeChild(nodes[1], nodes[2]));
+  REQUIRE(blocks.blocks() == 1);
+
+  // now 1 is only linked to 0
+  REQUIRE(blocks.removeChild(nodes[0], nodes[2]));
+  REQUIRE(blocks.blocks() == 2);
+  REQUIRE(blocks.block(nodes[0]) == blocks.block(nodes[1]));
+  REQUIRE(blocks.block(nodes[2]) != blocks.block(nodes[0]));
+  REQUIRE(blocks.blockNodes(blocks.block(nodes[3])).size() == 3);
+
+  // removing 2 leaves 3 and 4 on their own
+  blocks.removeNode(nodes[2]);
+  REQUIRE(!blocks.contains(nodes[2]));
+  REQUIRE(blocks.blocks() == 3);
+  REQUIRE(blocks.block(nodes[3]) != blocks.block(nodes[4]));
+  REQUIRE(nodes[4].children().size() == 0);
+}
+
+TEST_CASE("DFS") {
+  typedef DAG::Node<int> INode;
+  /*
+        0
+       / \
+      1   2
+       \ /
+        3
+  */
+  INode n0(0);
+  INode n1(1);
+  INode n2(2);
+  INode n3(3);
+  n0.addChild(n1);
+  n0.addChild(n2);
+  n1.addChild(n3);
+  n2.addChild(n3);
+
+  DAG::DFSVisitor<INode> dfs;
+  std::vector<int> pre, post;
+  dfs.setPreVisit([&pre](const INode* n, int) { pre.push_back(n->value()); });
+  dfs.setPostVisit([&post](const INode* n, int) { post.push_back(n->value()); });
+  auto nodes = dfs.traverseChildren(n0);
+  REQUIRE(nodes.size() == 4);
+  REQUIRE(pre.size() == 4);
+  REQUIRE(post.size() == 4);
+  REQUIRE(pre.front() == 0);
+  REQUIRE(post.back() == 0);
+  REQUIRE(post.front() == 3);  // 3 is a leaf so it finishes first
+  REQUIRE(dfs.postorder().front()->value() == 3);
+
+  REQUIRE(dfs.traverseChildren(n0, 1).size() == 3);
+  REQUIRE(dfs.traverseParents(n3).size() == 4);
+  REQUIRE(dfs.traverseUndirected(n1, 0).size() == 1);
+  REQUIRE(dfs.traverseUndirected(n1).size() == 4);
+
+  // a very deep chain must not overflow the stack
+  std::vector<INode> chain(200000);
+  for (std::size_t i = 1; i < chain.size(); ++i)
+    chain[i - 1].addChild(chain[i]);
+  DAG::DFSVisitor<INode> deep;
+  REQUIRE(deep.traverseChildren(chain[0]).size() == chain.size());
+  REQUIRE(deep.postorder().front() == &chain.back());
+}
+
+TEST_CASE("BFSLevel") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+
+  DAG::BFSLevelVisitor<INode> level;
+  DAG::BFSRecurseVisitor<INode> recurse;
+  for (int depth : {-1, 0, 1, 2, 3}) {
+    for (int start : {0, 4, 7}) {
+      auto expected = recurse.traverseUndirected(nodes[start], depth);
+      auto result = level.traverseUndirected(nodes[start], depth);
+      REQUIRE(result.size() == expected.size());
+      REQUIRE(std::is_permutation(result.begin(), result.end(), expected.begin()));
+      REQUIRE(level.traverseChildren(nodes[start], depth).size() == recurse.traverseChildren(nodes[start], depth).size());
+      REQUIRE(level.traverseParents(nodes[start], depth).size() == recurse.traverseParents(nodes[start], depth).size());
+    }
+  }
+
+  level.traverseChildren(nodes[0]);
+  REQUIRE(level.levels() == 3);
+  REQUIRE(level.levelOffsets() == std::vector<std::size_t>({0, 1, 4, 7}));
+
+  // a long chain is processed without recursion
+  std::vector<INode> chain(100000);
+  for (std::size_t i = 1; i < chain.size(); ++i)
+    chain[i - 1].addChild(chain[i]);
+  REQUIRE(level.traverseChildren(chain[0]).size() == chain.size());
+  REQUIRE(level.levels() == chain.size());
+}
+
+TEST_CASE("BFSTree") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+
+  DAG::BFSTreeVisitor<INode> bfs;
+  auto result = bfs.traverseUndirected(nodes[8]);
+  REQUIRE(result.size() == 9);
+  REQUIRE(bfs.depths().size() == 9);
+  REQUIRE(bfs.predecessors().size() == 9);
+  REQUIRE(bfs.predecessors()[0] == -1);
+  for (std::size_t i = 0; i < result.size(); ++i) {
+    auto path = bfs.path(i);
+    REQUIRE(path.front() == &nodes[8]);
+    REQUIRE(path.back() == result[i]);
+    REQUIRE(int(path.size()) == bfs.depths()[i] + 1);
+    for (std::size_t j = 1; j < path.size(); ++j)  // consecutive nodes are linked
+      REQUIRE((path[j - 1]->children().count(path[j]) + path[j - 1]->parents().count(path[j])) == 1);
+  }
+  REQUIRE(bfs.path(result.size()).empty());  // not a position of the last traversal
+  // 8 -> 7 -> 4 -> 1 -> 0 -> 3
+  auto three = std::find(result.begin(), result.end(), &nodes[3]) - result.begin();
+  REQUIRE(bfs.depths()[three] == 5);
+  // the nodes at distance 2 are 4 only
+  REQUIRE(bfs.levelOffsets()[3] - bfs.levelOffsets()[2] == 1);
+  REQUIRE(result[bfs.levelOffsets()[2]] == &nodes[4]);
+}
+
+TEST_CASE("TopologicalSort") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+
+  DAG::TopologicalSort<INode> topo;
+  REQUIRE(topo.sort(nodes[5]));
+  REQUIRE(topo.order().size() == 9);
+  REQUIRE(topo.layers() == 3);
+  REQUIRE(topo.layerOffsets() == std::vector<std::size_t>({0, 2, 6, 9}));  // {0,7} {1,2,3,8} {4,5,6}
+  auto position = [&topo](const INode& n) {
+    return std::find(topo.order().begin(), topo.order().end(), &n) - topo.order().begin();
+  };
+  for (auto& link : exampleLinks)
+    REQUIRE(position(nodes[link.first]) < position(nodes[link.second]));
+
+  // adding 6 -> 0 creates the cycle 0 -> 3 -> 6 -> 0
+  nodes[6].addChild(nodes[0]);
+  REQUIRE(!topo.sort(nodes[5]));
+  REQUIRE(topo.hasCycle());
+  REQUIRE(topo.unsorted().size() == 7);  // only 7 and 8 can be sorted
+  auto cycle = topo.cycle();
+  REQUIRE(cycle.size() == 3);
+  for (std::size_t i = 0; i < cycle.size(); ++i)
+    REQUIRE(cycle[i]->children().count(cycle[(i + 1) % cycle.size()]) == 1);
+
+  // larger random graph sorted in parallel
+  std::vector<INode> many(20000);
+  std::mt19937 random(1);
+  for (std::size_t i = 1; i < many.size(); ++i)
+    for (int k = 0; k < 3; ++k)
+      many[random() % i].addChild(many[i]);
+  auto all = pointers(many);
+  DAG::ThreadPool pool(4);
+  DAG::TopologicalSort<INode> parallel(&pool);
+  parallel.setGrainSize(16);
+  DAG::TopologicalSort<INode> serial;
+  REQUIRE(parallel.sort(all));
+  REQUIRE(serial.sort(all));
+  REQUIRE(parallel.order().size() == many.size());
+  REQUIRE(parallel.layerOffsets() == serial.layerOffsets());
+  const auto& graph = parallel.graph();
+  for (DAG::CompactGraph<INode>::Index i = 0; i < graph.size(); ++i)
+    for (auto child : graph.children(i))
+      REQUIRE(parallel.layer(i) < parallel.layer(child));
+}
+
+TEST_CASE("DynamicTopologicalOrder") {
+  typedef DAG::Node<int> INode;
+  std::vector<INode> nodes;
+  for (int i = 0; i < 5; ++i)
+    nodes.emplace_back(i);
+  DAG::DynamicTopologicalOrder<INode> dag;
+  // links added "backwards" so that the order has to be changed
+  REQUIRE(dag.addChild(nodes[3], nodes[4]));
+  REQUIRE(dag.addChild(nodes[2], nodes[3]));
+  REQUIRE(dag.addChild(nodes[1], nodes[2]));
+  REQUIRE(dag.addChild(nodes[4], nodes[0]));
+  REQUIRE(dag.addChild(nodes[1], nodes[0]));
+  for (int i = 1; i < 4; ++i)
+    REQUIRE(dag.position(nodes[i]) < dag.position(nodes[i + 1]));
+  REQUIRE(dag.position(nodes[4]) < dag.position(nodes[0]));
+
+  REQUIRE(!dag.addChild(nodes[0], nodes[1]));  // 1 -> 2 -> 3 -> 4 -> 0 -> 1
+  REQUIRE(!dag.addChild(nodes[4], nodes[2]));
+  REQUIRE(!dag.addChild(nodes[2], nodes[2]));
+  REQUIRE(nodes[0].children().size() == 0);
+  REQUIRE(nodes[4].children().size() == 1);
+  REQUIRE(!dag.canAddChild(nodes[0], nodes[3]));
+  REQUIRE(dag.canAddChild(nodes[3], nodes[0]));
+
+  // once the link 2 -> 3 is removed, 4 -> 2 is allowed
+  dag.removeChild(nodes[2], nodes[3]);
+  REQUIRE(dag.addChild(nodes[4], nodes[2]));
+  REQUIRE(dag.position(nodes[4]) < dag.position(nodes[2]));
+
+  // random insertions agree with a full traversal
+  std::vector<INode> many(300);
+  DAG::DynamicTopologicalOrder<INode> random_dag;
+  DAG::BFSVisitor<INode> bfs;
+  std::mt19937 random(2);
+  for (int k = 0; k < 2000; ++k) {
+    INode& parent = many[random() % many.size()];
+    INode& child = many[random() % many.size()];
+    auto descendants = bfs.traverseChildren(child);
+    bool cycle = std::find(descendants.begin(), descendants.end(), &parent) != descendants.end();
+    REQUIRE(random_dag.addChild(parent, child) == !cycle);
+  }
+  for (auto& n : many)
+    for (auto child : n.children())
+      REQUIRE(random_dag.position(n) < random_dag.position(*child));
+
+  // nodes linked before they are tracked: 5 -> 6 -> 7 made with Node::addChild, 8 -> 5 added through dag
+  std::vector<INode> linked;
+  for (int i = 5; i < 11; ++i)
+    linked.emplace_back(i);
+  linked[0].addChild(linked[1]);
+  linked[1].addChild(linked[2]);
+  REQUIRE(!dag.canAddChild(linked[2], linked[0]));  // untracked, but the links are followed
+  REQUIRE(dag.addChild(linked[3], linked[0]));       // tracks 5 6 7 in the order of their links
+  REQUIRE(dag.position(linked[3]) < dag.position(linked[0]));
+  REQUIRE(dag.position(linked[0]) < dag.position(linked[1]));
+  REQUIRE(dag.position(linked[1]) < dag.position(linked[2]));
+  REQUIRE(!dag.addChild(linked[2], linked[3]));  // 8 -> 5 -> 6 -> 7 -> 8
+  REQUIRE(dag.position(nodes[4]) < dag.position(nodes[2]));  // the earlier order is kept valid
+  // a cycle made before tracking is refused
+  linked[4].addChild(linked[5]);
+  linked[5].addChild(linked[4]);
+  REQUIRE(!dag.addNode(linked[4]));
+  REQUIRE(!dag.contains(linked[5]));
+  REQUIRE(!dag.addChild(linked[0], linked[5]));
+  // so is a link to a cycle from an untracked node, which is not tracked either
+  INode lone(11);
+  REQUIRE(!dag.addChild(lone, linked[5]));
+  REQUIRE(!dag.contains(lone));
+
+  // adopting nodes linked to tracked nodes only reorders the region affected by these links
+  std::vector<INode> chain(100), loose(3);
+  DAG::DynamicTopologicalOrder<INode> ordered;
+  for (std::size_t i = 1; i < chain.size(); ++i)
+    REQUIRE(ordered.addChild(chain[i - 1], chain[i]));
+  std::vector<long> before;
+  for (auto& n : chain)
+    before.push_back(ordered.position(n));
+  loose[0].addChild(loose[1]);
+  loose[1].addChild(chain[50]);  // made directly, followed when loose[0] is adopted
+  REQUIRE(ordered.addNode(loose[0]));
+  REQUIRE(ordered.position(loose[0]) < ordered.position(loose[1]));
+  REQUIRE(ordered.position(loose[1]) < ordered.position(chain[50]));
+  for (std::size_t i = 1; i < chain.size(); ++i)
+    REQUIRE(ordered.position(chain[i - 1]) < ordered.position(chain[i]));
+  for (std::size_t i = 0; i < 50; ++i)
+    REQUIRE(ordered.position(chain[i]) == before[i]);
+  // a cycle through tracked nodes: chain[60] -> loose[2] -> chain[10]
+  chain[60].addChild(loose[2]);
+  loose[2].addChild(chain[10]);
+  REQUIRE(!ordered.addNode(loose[2]));
+  REQUIRE(!ordered.contains(loose[2]));
+  for (std::size_t i = 1; i < chain.size(); ++i)
+    REQUIRE(ordered.position(chain[i - 1]) < ordered.position(chain[i]));
+}
+
+TEST_CASE("ReachabilityIndex") {
+  typedef DAG::Node<int> INode;
+  std::vector<INode> nodes(2000);
+  std::mt19937 random(3);
+  for (std::size_t i = 1; i < nodes.size(); ++i)
+    for (int k = 0; k < 2; ++k)
+      nodes[random() % i].addChild(nodes[i]);
+  auto all = pointers(nodes);
+  DAG::CompactGraph<INode> graph(all);
+  DAG::ReachabilityIndex<INode> index;
+  REQUIRE(index.build(graph));
+
+  DAG::BFSVisitor<INode> bfs;
+  for (int k = 0; k < 50; ++k) {
+    const INode& a = nodes[random() % nodes.size()];
+    auto descendants = bfs.traverseChildren(a);
+    DAG::Nodeset<INode> reached(descendants.begin(), descendants.end());
+    for (auto& b : nodes) {
+      REQUIRE(index.reaches(&a, &b) == (reached.count(&b) == 1));
+      REQUIRE(index.isDescendant(&b, &a) == (reached.count(&b) == 1));
+    }
+  }
+
+  // a cycle can not be indexed
+  nodes[5].addChild(nodes[0]);
+  nodes[0].addChild(nodes[5]);
+  DAG::CompactGraph<INode> cyclic(all);
+  REQUIRE(!index.build(cyclic));
+}
+
+TEST_CASE("CommonAncestors") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+
+  DAG::CommonAncestors<INode> ancestors;
+  REQUIRE(ancestors.lowest(nodes[5], nodes[6]) == &nodes[1]);
+  REQUIRE(ancestors.lowest(nodes[2], nodes[6]) == &nodes[0]);
+  REQUIRE(ancestors.lowest(nodes[1], nodes[6]) == &nodes[1]);  // a node is its own ancestor
+  REQUIRE(ancestors.lowest(nodes[4], nodes[8]) == &nodes[7]);
+  REQUIRE(ancestors.lowest(nodes[2], nodes[8]) == nullptr);
+  REQUIRE(ancestors.minimal({&nodes[4], &nodes[5], &nodes[6]}) == DAG::Nodevector<INode>{&nodes[1]});
+
+  auto all = pointers(nodes);
+  DAG::CompactGraph<INode> graph(all);
+  DAG::CommonAncestorIndex<INode> index;
+  REQUIRE(index.build(graph));
+  REQUIRE(index.lowest(5, 6) == 1);
+  REQUIRE(index.lowest(2, 8) == DAG::CompactGraph<INode>::npos);
+  REQUIRE(index.minimal(DAG::Nodevector<INode>{&nodes[4], &nodes[8]}) == DAG::Nodevector<INode>{&nodes[7]});
+  INode outside(9);  // not in the graph
+  REQUIRE(index.minimal(DAG::Nodevector<INode>{&nodes[4], &outside}).empty());
+  REQUIRE(index.lowest(5, DAG::CompactGraph<INode>::npos) == DAG::CompactGraph<INode>::npos);
+  REQUIRE(index.minimalBatch({{5, 6}, {5, 9}}) == (std::vector<std::vector<unsigned>>{{1}, {}}));
+
+  // random graph: both methods agree with intersecting the full ancestor sets
+  std::vector<INode> many(500);
+  std::mt19937 random(4);
+  for (std::size_t i = 1; i < many.size(); ++i)
+    for (int k = 0; k < 2; ++k)
+      many[std::max<int>(0, i - 1 - random() % 50)].addChild(many[i]);
+  all = pointers(many);
+  DAG::CompactGraph<INode> big(all);
+  REQUIRE(index.build(big));
+  DAG::BFSVisitor<INode> bfs;
+  std::vector<std::vector<unsigned>> queries;
+  std::vector<std::vector<unsigned>> expected;
+  for (int k = 0; k < 100; ++k) {
+    unsigned a = random() % many.size();
+    unsigned b = random() % many.size();
+    auto up = bfs.traverseParents(many[a]);
+    DAG::Nodeset<INode> common(up.begin(), up.end());
+    DAG::Nodeset<INode> both;
+    for (auto n : bfs.traverseParents(many[b]))
+      if (common.count(n)) both.insert(n);
+    std::vector<unsigned> minimal;  // common ancestors with no child that is a common ancestor
+    for (auto n : both) {
+      bool isMinimal = true;
+      for (auto child : n->children())
+        if (both.count(child)) isMinimal = false;
+      if (isMinimal) minimal.push_back(big.index(n));
+    }
+    std::sort(minimal.begin(), minimal.end());
+
+    std::vector<unsigned> found;
+    for (auto n : ancestors.minimal({&many[a], &many[b]}))
+      found.push_back(big.index(n));
+    std::sort(found.begin(), found.end());
+    REQUIRE(found == minimal);
+    found = index.minimal(std::vector<unsigned>{a, b});
+    std::sort(found.begin(), found.end());
+    REQUIRE(found == minimal);
+    queries.push_back({a, b});
+    expected.push_back(minimal);
+  }
+  DAG::ThreadPool pool(3);
+  auto batch = index.minimalBatch(queries, &pool);
+  for (std::size_t k = 0; k < batch.size(); ++k) {
+    std::sort(batch[k].begin(), batch[k].end());
+    REQUIRE(batch[k] == expected[k]);
+  }
+
+  // more than 64 query nodes, taken from the descendants of one node so that they have common ancestors
+  DAG::Nodevector<INode> query;
+  for (auto n : bfs.traverseChildren(many[300]))
+    if (query.size() < 150 && random() % 2) query.push_back(n);
+  REQUIRE(query.size() > 64);
+  DAG::Nodeset<INode> common;
+  for (std::size_t k = 0; k < query.size(); ++k) {
+    auto up = bfs.traverseParents(*query[k]);
+    DAG::Nodeset<INode> ancestorsOf(up.begin(), up.end());
+    if (k == 0) common = ancestorsOf;
+    for (auto it = common.begin(); it != common.end();)
+      it = ancestorsOf.count(*it) ? std::next(it) : common.erase(it);
+  }
+  std::vector<unsigned> minimal;
+  std::vector<unsigned> indices;
+  for (auto n : common) {
+    bool isMinimal = true;
+    for (auto child : n->children())
+      if (common.count(child)) isMinimal = false;
+    if (isMinimal) minimal.push_back(big.index(n));
+  }
+  std::sort(minimal.begin(), minimal.end());
+  REQUIRE(!minimal.empty());
+  std::vector<unsigned> found;
+  for (auto n : ancestors.minimal(query))
+    found.push_back(big.index(n));
+  std::sort(found.begin(), found.end());
+  REQUIRE(found == minimal);
+  for (auto n : query)
+    indices.push_back(big.index(n));
+  found = index.minimal(indices);
+  std::sort(found.begin(), found.end());
+  REQUIRE(found == minimal);
+
+  // near trees with cross links and several roots: answered from the spanning forest or by a search
+  for (int seed = 0; seed < 4; ++seed) {
+    std::vector<INode> tree(400);
+    std::vector<std::vector<char>> above(tree.size(), std::vector<char>(tree.size(), 0));
+    for (std::size_t i = 0; i < tree.size(); ++i) {
+      above[i][i] = 1;
+      std::vector<std::size_t> parents;
+      if (i > 0 && random() % 50) parents.push_back(i - 1 - random() % std::min<std::size_t>(i, 20));
+      if (i > 0 && random() % 6 == 0) parents.push_back(random() % i);
+      for (auto p : parents) {
+        tree[p].addChild(tree[i]);
+        for (std::size_t k = 0; k < i; ++k)
+          above[i][k] |= above[p][k];
+      }
+    }
+    DAG::CompactGraph<INode> forest(pointers(tree));
+    DAG::CommonAncestorIndex<INode> forestIndex;
+    REQUIRE(forestIndex.build(forest));
+    for (int k = 0; k < 200; ++k) {
+      std::vector<std::size_t> nodes(1 + random() % 4);
+      for (auto& n : nodes)
+        n = random() % tree.size();
+      auto common = [&](std::size_t c) {
+        for (auto n : nodes)
+          if (!above[n][c]) return false;
+        return true;
+      };
+      std::vector<unsigned> minimal;
+      for (std::size_t c = 0; c < tree.size(); ++c) {
+        if (!common(c)) continue;
+        bool isMinimal = true;
+        for (auto child : tree[c].children())
+          if (common(static_cast<const INode*>(child) - tree.data())) isMinimal = false;
+        if (isMinimal) minimal.push_back(forest.index(&tree[c]));
+      }
+      std::sort(minimal.begin(), minimal.end());
+      std::vector<unsigned> indices;
+      for (auto n : nodes)
+        indices.push_back(forest.index(&tree[n]));
+      std::vector<unsigned> found = forestIndex.minimal(indices);
+      std::sort(found.begin(), found.end());
+      REQUIRE(found == minimal);
+    }
+    REQUIRE(forestIndex.searches() > 0);
+    REQUIRE(forestIndex.searches() < 200);
+  }
+}
+
+TEST_CASE("BidirectionalSearch") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+
+  DAG::BidirectionalSearch<INode> search;
+  auto path = search.shortestPath(nodes[8], nodes[2]);  // 8 7 4 1 0 2
+  REQUIRE(path.size() == 6);
+  REQUIRE(path.front() == &nodes[8]);
+  REQUIRE(path.back() == &nodes[2]);
+  REQUIRE(search.shortestPath(nodes[8], nodes[2], DAG::VisitType::UNDIRECTED, 4).empty());
+  REQUIRE(search.shortestPath(nodes[0], nodes[6], DAG::VisitType::CHILDREN).size() == 3);
+  REQUIRE(search.shortestPath(nodes[6], nodes[0], DAG::VisitType::CHILDREN).empty());
+  REQUIRE(search.shortestPath(nodes[6], nodes[0], DAG::VisitType::PARENTS).size() == 3);
+  REQUIRE(search.shortestPath(nodes[3], nodes[3]).size() == 1);
+
+  // random graph: same lengths as a breadth first search and far fewer nodes visited
+  std::vector<INode> many(20000);
+  std::mt19937 random(5);
+  for (std::size_t i = 1; i < many.size(); ++i)
+    many[random() % i].addChild(many[i]);
+  DAG::BFSTreeVisitor<INode> bfs;
+  std::size_t visited = 0;
+  for (int k = 0; k < 20; ++k) {
+    const INode& a = many[random() % many.size()];
+    const INode& b = many[random() % many.size()];
+    auto result = bfs.traverseUndirected(a);
+    auto position = std::find(result.begin(), result.end(), &b) - result.begin();
+    path = search.shortestPath(a, b);
+    REQUIRE(int(path.size()) == bfs.depths()[position] + 1);
+    for (std::size_t j = 1; j < path.size(); ++j)
+      REQUIRE((path[j - 1]->children().count(path[j]) + path[j - 1]->parents().count(path[j])) == 1);
+    visited += search.visited();
+  }
+  REQUIRE(visited < 20 * many.size() / 4);
+}
+
+TEST_CASE("WeightedPaths") {
+  typedef DAG::Node<int> INode;
+  //  0 -1-> 1 -1-> 3
+  //  0 -5-> 2 -1-> 3
+  //  1 -2-> 2
+  std::vector<INode> nodes;
+  for (int i = 0; i < 4; ++i)
+    nodes.emplace_back(i);
+  std::map<std::pair<int, int>, double> weights{{{0, 1}, 1.}, {{1, 3}, 1.}, {{0, 2}, 5.}, {{2, 3}, 1.}, {{1, 2}, 2.}};
+  for (auto& link : weights)
+    nodes[link.first.first].addChild(nodes[link.first.second]);
+  auto all = pointers(nodes);
+  DAG::CompactGraph<INode> graph(all, [&weights](const INode* parent, const INode* child) {
+    return weights.at({parent->value(), child->value()});
+  });
+  REQUIRE(graph.weighted());
+
+  DAG::WeightedPaths<INode> paths;
+  REQUIRE(paths.build(graph));
+  paths.shortest(0);
+  REQUIRE(paths.distances() == std::vector<double>({0., 1., 3., 2.}));
+  REQUIRE(paths.path(2) == DAG::Nodevector<INode>({&nodes[0], &nodes[1], &nodes[2]}));
+  paths.longest(0);
+  REQUIRE(paths.distances()[3] == 6.);
+  REQUIRE(paths.path(3) == DAG::Nodevector<INode>({&nodes[0], &nodes[2], &nodes[3]}));
+  paths.shortest(2);
+  REQUIRE(!paths.reached(0));
+  REQUIRE(paths.path(0).empty());
+  REQUIRE(paths.criticalPath() == 3);
+  REQUIRE(paths.path(3).size() == 3);
+
+  // unweighted graph: distances count links
+  DAG::CompactGraph<INode> plain(all);
+  DAG::WeightedPaths<INode> hops;
+  REQUIRE(hops.build(plain));
+  hops.longest(0);
+  REQUIRE(hops.distances()[3] == 3.);
+
+  // random graph: parallel multi source agrees with the serial result
+  std::vector<INode> many(5000);
+  std::mt19937 random(6);
+  for (std::size_t i = 1; i < many.size(); ++i)
+    for (int k = 0; k < 3; ++k)
+      many[random() % i].addChild(many[i]);
+  all = pointers(many);
+  DAG::CompactGraph<INode> big(all, [](const INode* parent, const INode* child) { return double((parent - child) % 7); });
+  DAG::ThreadPool pool(4);
+  DAG::WeightedPaths<INode> serial;
+  DAG::WeightedPaths<INode> parallel(&pool);
+  parallel.setGrainSize(8);
+  REQUIRE(serial.build(big));
+  REQUIRE(parallel.build(big));
+  std::vector<unsigned> sources{0, 10, 100};
+  serial.shortest(sources);
+  parallel.shortest(sources);
+  REQUIRE(serial.distances() == parallel.distances());
+  serial.longest(sources);
+  parallel.longest(sources);
+  REQUIRE(serial.distances() == parallel.distances());
+}
 
+TEST_CASE("EdgeColumn") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+  auto all = pointers(nodes);
+  DAG::CompactGraph<INode> graph(all);
+
+  // link type 1 if the child is odd, distance is the difference of the values
+  DAG::EdgeColumn<char> type(graph, [](const INode* parent, const INode* child) { return char(child->value() % 2); });
+  DAG::EdgeColumn<float> distance(graph, [](const INode* parent, const INode* child) {
+    return float(child->value() - parent->value());
+  });
+  for (unsigned i = 0; i < graph.size(); ++i) {
+    graph.forEachLink(i, DAG::VisitType::UNDIRECTED, [&](const DAG::CompactLink& link) {
+      const INode* parent = link.toParent ? graph.node(link.node) : graph.node(i);
+      const INode* child = link.toParent ? graph.node(i) : graph.node(link.node);
+      REQUIRE(type[link] == child->value() % 2);
+      REQUIRE(distance[link] == float(child->value() - parent->value()));
+    });
+  }
+
+  DAG::CompactBFS<INode> bfs(graph);
+  REQUIRE(bfs.traverse(0, DAG::VisitType::UNDIRECTED).size() == 9);
+  REQUIRE(bfs.traverse(0, DAG::VisitType::CHILDREN, 1).size() == 4);
+  REQUIRE(bfs.levelOffsets() == std::vector<std::size_t>({0, 1, 4}));
+  // only odd children: 0 -> 1 -> 5 and 0 -> 3
+  auto odd = bfs.traverse(0, DAG::VisitType::CHILDREN, -1,
+                          [&type](unsigned, const DAG::CompactLink& link) { return type[link] == 1; });
+  REQUIRE(odd.size() == 4);
+  REQUIRE(bfs.visited(5));
+  REQUIRE(!bfs.visited(6));
+  // only short links (distance < 4): everything but 5 (1 -> 5 has distance 4)
+  auto near = bfs.traverse(4, DAG::VisitType::UNDIRECTED, -1, [&distance](unsigned, const DAG::CompactLink& link) {
+    return std::abs(distance[link]) < 4;
+  });
+  REQUIRE(near.size() == 8);
+  REQUIRE(!bfs.visited(5));
+}
+
+TEST_CASE("FloodFillLinks") {
+  typedef DAG::Node<long long> PFNode;
+  typedef std::map<long long, PFNode> Nodes;
+  // chain 1 - 2 - 3 - 4 - 5 where the link weight is the value of the child
+  Nodes myNodes;
+  for (long long id = 1; id <= 5; ++id)
+    myNodes.emplace(id, PFNode(id));
+  for (long long id = 1; id < 5; ++id)
+    myNodes[id].addChild(myNodes[id + 1]);
+
+  DAG::FloodFill<long long> FFill;
+  auto blocks = FFill.traverse(myNodes, [](const PFNode* parent, const PFNode* child) { return child->value() != 3; });
+  REQUIRE(blocks.size() == 2);  // {1,2} {3,4,5}
+  REQUIRE(blocks[0].size() == 2);
+  REQUIRE(blocks[1].size() == 3);
+
+  auto weight = [](const PFNode* parent, const PFNode* child) { return double(child->value()); };
+  auto levels = FFill.traverse(myNodes, weight, {4., 0., 2.});
+  REQUIRE(levels.size() == 3);
+  REQUIRE(levels[0].threshold == 0.);
+  REQUIRE(levels[0].blocks.size() == 5);  // no links
+  REQUIRE(levels[1].blocks.size() == 4);  // {1,2} 3 4 5
+  REQUIRE(levels[2].blocks.size() == 2);  // {1,2,3,4} 5
+  // nesting: every node of a block is in the parent block
+  for (std::size_t l = 0; l + 1 < levels.size(); ++l) {
+    REQUIRE(levels[l].parents.size() == levels[l].blocks.size());
+    for (std::size_t b = 0; b < levels[l].blocks.size(); ++b) {
+      const auto& outer = levels[l + 1].blocks[levels[l].parents[b]];
+      for (auto node : levels[l].blocks[b])
+        REQUIRE(std::find(outer.begin(), outer.end(), node) != outer.end());
+    }
+  }
+  REQUIRE(levels[2].parents[0] == DAG::FloodFill<long long>::npos);
+}
+
+TEST_CASE("FloodFillContainers") {
+  typedef DAG::Node<int> INode;
+  // two blocks {0,1,2} {3,4} held in different kinds of container
+  std::vector<INode> nodes;
+  for (int i = 0; i < 5; ++i)
+    nodes.emplace_back(i);
+  nodes[0].addChild(nodes[1]);
+  nodes[2].addChild(nodes[1]);
+  nodes[3].addChild(nodes[4]);
+
+  DAG::FloodFill<int> FFill;
+  REQUIRE(FFill.traverse(nodes).size() == 2);
+  DAG::Nodevector<INode> pointers{&nodes[4], &nodes[0]};
+  auto blocks = FFill.traverse(pointers);
+  REQUIRE(blocks.size() == 2);
+  REQUIRE(blocks[0].size() == 2);
+  REQUIRE(blocks[1].size() == 3);
+
+  std::unordered_map<int, INode> byId;
+  for (int i = 0; i < 3; ++i)
+    byId.emplace(i, INode(i));
+  byId[0].addChild(byId[1]);
+  REQUIRE(FFill.traverse(byId).size() == 2);
+
+  DAG::CompactGraph<INode> graph(DAG::Nodevector<INode>{&nodes[0], &nodes[1], &nodes[2], &nodes[3], &nodes[4]});
+  blocks = FFill.traverse(graph);
+  REQUIRE(blocks.size() == 2);
+  blocks = FFill.traverse(graph, [](const INode* parent, const INode* child) { return parent->value() != 2; });
+  REQUIRE(blocks.size() == 3);
+}
+
+TEST_CASE("FloodFillStream") {
+  typedef DAG::Node<int> INode;
+  // 50 blocks of 4 nodes: 4k -> 4k+1 -> 4k+2, 4k+3 -> 4k+2
+  std::vector<INode> nodes;
+  for (int i = 0; i < 200; ++i)
+    nodes.emplace_back(i);
+  for (int k = 0; k < 50; ++k) {
+    nodes[4 * k].addChild(nodes[4 * k + 1]);
+    nodes[4 * k + 1].addChild(nodes[4 * k + 2]);
+    nodes[4 * k + 3].addChild(nodes[4 * k + 2]);
+  }
+  DAG::FloodFill<int> FFill;
+  std::size_t blocks = 0;
+  FFill.stream(nodes, [&blocks](DAG::Nodevector<INode>& block) {
+    REQUIRE(block.size() == 4);
+    ++blocks;
+  });
+  REQUIRE(blocks == 50);
+
+  DAG::ThreadPool pool(3);
+  std::atomic<int> sum(0);
+  std::atomic<std::size_t> count(0);
+  FFill.stream(nodes, pool, [&](DAG::Nodevector<INode>& block) {
+    for (auto node : block)
+      sum += node->value();
+    ++count;
+  }, 2);
+  REQUIRE(count == 50);
+  REQUIRE(sum == 199 * 200 / 2);
+}
+
+TEST_CASE("PointerSet") {
+  std::vector<int> values(100);
+  DAG::PointerSet<const int*> set;
+  for (auto& value : values)
+    REQUIRE(set.insert(&value));
+  REQUIRE(set.size() == 100);
+  REQUIRE(!set.insert(&values[50]));
+  REQUIRE(set.contains(&values[99]));
+  set.clear();
+  REQUIRE(set.empty());
+  REQUIRE(!set.contains(&values[99]));
+  REQUIRE(set.insert(&values[99]));
+}
+
+TEST_CASE("EventBatch") {
+  typedef DAG::Node<int> INode;
+  // event e has e % 5 + 1 blocks, each a chain of 3 nodes
+  std::vector<std::vector<INode>> events(200);
+  for (std::size_t e = 0; e < events.size(); ++e) {
+    int blocks = e % 5 + 1;
+    events[e].reserve(3 * blocks);  // the nodes must not move once linked
+    for (int i = 0; i < 3 * blocks; ++i)
+      events[e].emplace_back(i);
+    for (int b = 0; b < blocks; ++b) {
+      events[e][3 * b].addChild(events[e][3 * b + 1]);
+      events[e][3 * b + 2].addChild(events[e][3 * b + 1]);
+    }
+  }
+  DAG::ThreadPool pool(3);
+  DAG::EventBatch<int> batch(&pool);
+  batch.setGrainSize(4);
+  REQUIRE(batch.workers() == 3);
+  std::vector<std::size_t> found(events.size(), 0);
+  std::vector<int> bad(batch.workers(), 0);
+  batch.process(events, [&](std::size_t event, const DAG::FloodFill<int>::Blocks& blocks, unsigned worker) {
+    found[event] = blocks.size();
+    for (std::size_t b = 0; b < blocks.size(); ++b)
+      if (blocks.block(b).size() != 3) ++bad[worker];
+  });
+  for (std::size_t e = 0; e < events.size(); ++e)
+    REQUIRE(found[e] == e % 5 + 1);
+  REQUIRE(std::accumulate(bad.begin(), bad.end(), 0) == 0);
+
+  // cutting the links to node 1 of each chain leaves single nodes
+  DAG::EventBatch<int> serial;
+  serial.process(events, [](const INode*, const INode* child) { return child->value() % 3 != 1; },
+                 [&](std::size_t event, const DAG::FloodFill<int>::Blocks& blocks, unsigned) {
+                   found[event] = blocks.size();
+                 });
+  for (std::size_t e = 0; e < events.size(); ++e)
+    REQUIRE(found[e] == 3 * (e % 5 + 1));
+}
+
+TEST_CASE("ReuseBuffers") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+
+  DAG::BFSVisitor<INode> bfs;
+  DAG::BFSTreeVisitor<INode> tree;
+  DAG::FloodFill<int> fill;
+  DAG::FloodFill<int>::Blocks blocks;
+  auto all = pointers(nodes);
+  DAG::CompactGraph<INode> graph(all);
+  DAG::CompactBFS<INode> compact(graph);
+  bfs.setReuseBuffers(true);
+  tree.setReuseBuffers(true);
+  auto everything = [&]() {
+    std::size_t found = bfs.traverseChildren(nodes[0]).size();
+    found += bfs.traverseParents(nodes[6]).size();
+    found += bfs.traverseUndirected(nodes[8]).size();
+    found += tree.traverseUndirected(nodes[2]).size();
+    found += compact.traverse(0, DAG::VisitType::CHILDREN, -1, DAG::TagMask::all()).size();
+    fill.fill(nodes, blocks);
+    return found + blocks.size();
+  };
+  std::size_t first = everything();  // grows the buffers
+  std::size_t before = allocationCount();
+  std::size_t second = everything();
+  std::size_t third = everything();
+  std::size_t after = allocationCount();  // NB REQUIRE itself allocates
+  REQUIRE(after == before);
+  REQUIRE(first == 7 + 4 + 9 + 9 + 7 + 1);
+  REQUIRE(second == first);
+  REQUIRE(third == first);
+
+  // without reuse the traversal allocates again but gives the same result
+  DAG::BFSVisitor<INode> plain;
+  before = allocationCount();
+  std::size_t size = plain.traverseUndirected(nodes[8]).size();
+  size += plain.traverseUndirected(nodes[8]).size();
+  after = allocationCount();
+  REQUIRE(size == 18);
+  REQUIRE(after > before);
+}
+
+TEST_CASE("PmrGraph") {
+  typedef DAG::pmr::Node<int> PNode;
+  // all the memory comes from a buffer, anything else would use operator new (or fail: no upstream)
+  std::vector<char> buffer(1 << 16);
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+  std::vector<double> thresholds{0., 10.};  // given by the caller (moved in below)
+  std::size_t before = allocationCount();
+  std::size_t blockCount = 0, blockSize = 0, descendants = 0;
+  {
+    std::pmr::vector<PNode> nodes(&arena);
+    nodes.reserve(10);  // the nodes must not move once they are linked
+    for (int i = 0; i < 10; ++i)
+      nodes.emplace_back(i);  // node 9 is on its own
+    linkExample(nodes);
+
+    DAG::pmr::BFSVisitor<int> bfs(&arena);
+    descendants = bfs.traverseChildren(nodes[0]).size();
+    DAG::pmr::FloodFill<int> fill(&arena);
+    auto blocks = fill.traverse(nodes);
+    blockCount = blocks.size();
+    blockSize = blocks[0].size();
+    DAG::pmr::FloodFill<int>::Blocks flat(&arena);
+    fill.fill(nodes, flat);
+    blockCount += flat.size();
+    auto levels = fill.traverse(nodes, [](const PNode* parent, const PNode*) { return double(parent->value()); },
+                                std::move(thresholds));
+    blockCount += levels[0].blocks.size() + levels[1].blocks.size();
+  }
+  std::size_t after = allocationCount();
+  REQUIRE(after == before);
+  REQUIRE(descendants == 7);
+  REQUIRE(blockCount == 2 + 2 + 7 + 2);  // only the links from node 0 have weight 0: {0 1 2 3} 4 5 6 7 8 9
+  REQUIRE(blockSize == 9);
+}
+
+TEST_CASE("MultiSource") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+
+  // descendants of 3 and 7 in one pass: 3 6 7 8 4
+  DAG::BFSVisitor<INode> bfs;
+  bfs.setRecordSources(true);
+  auto& found = bfs.traverseChildren(DAG::Nodevector<INode>{&nodes[3], &nodes[7], &nodes[3]});
+  REQUIRE(found.size() == 5);
+  REQUIRE(bfs.sources().size() == 5);
+  for (std::size_t i = 0; i < found.size(); ++i) {
+    int value = found[i]->value();
+    REQUIRE(bfs.sources()[i]->value() == (value == 3 || value == 6 ? 3 : 7));
+  }
+
+  DAG::BFSRecurseVisitor<INode> recurse;
+  recurse.setRecordSources(true);
+  auto& recursed = recurse.traverseChildren(DAG::Nodevector<INode>{&nodes[3], &nodes[7]});
+  REQUIRE(recurse.sources().size() == 5);
+  for (std::size_t i = 0; i < recursed.size(); ++i) {
+    int value = recursed[i]->value();
+    REQUIRE(recurse.sources()[i]->value() == (value == 3 || value == 6 ? 3 : 7));
+  }
+
+  // the nearest start node wins: 4 is one link from 1 and two links from 0
+  DAG::BFSTreeVisitor<INode> tree;
+  tree.setRecordSources(true);
+  auto& reached = tree.traverseUndirected(DAG::Nodevector<INode>{&nodes[0], &nodes[1]});
+  REQUIRE(reached.size() == 9);
+  for (std::size_t i = 0; i < reached.size(); ++i)
+    if (reached[i]->value() == 4) REQUIRE(tree.sources()[i] == &nodes[1]);
+    else if (reached[i]->value() == 2) REQUIRE(tree.sources()[i] == &nodes[0]);
+
+  bfs.setRecordSources(false);
+  REQUIRE(bfs.traverseParents(DAG::Nodevector<INode>{&nodes[6], &nodes[8]}).size() == 6);  // 6 1 3 0 8 7
+  REQUIRE(bfs.sources().empty());
+}
+
+/// a derived visitor written when the start nodes of traverse were given as a Nodeset
+template <typename N>
+class SetStartVisitor : public DAG::BFSTreeVisitor<N> {
+public:
+  const DAG::Nodevector<N>& traverseFrom(const DAG::Nodeset<N>& starts) {
+    this->traverse(starts, DAG::VisitType::CHILDREN, -1);
+    return this->m_result;
+  }
+};
+
+/// a derived visitor that overrides the search, as the ones written before the visitors took several start nodes
+template <typename N>
+class CountingVisitor : public DAG::BFSVisitor<N> {
+public:
+  int calls = 0;
+
+protected:
+  void traverse(const DAG::Nodeset<N>& nodes, DAG::VisitType visittype, int depth) override {
+    ++calls;
+    DAG::BFSVisitor<N>::traverse(nodes, visittype, depth);
+  }
+};
+
+TEST_CASE("NodesetStart") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+  SetStartVisitor<INode> visitor;
+  REQUIRE(visitor.traverseFrom(DAG::Nodeset<INode>{&nodes[3], &nodes[7]}).size() == 5);  // 3 7 6 8 4
+
+  // the public traversals go through the override
+  CountingVisitor<INode> counting;
+  counting.setReuseBuffers(true);
+  REQUIRE(counting.traverseChildren(nodes[0]).size() == 7);
+  REQUIRE(counting.traverseParents(DAG::Nodevector<INode>{&nodes[6], &nodes[8], &nodes[6]}).size() == 6);
+  REQUIRE(counting.calls == 2);
+}
+
+TEST_CASE("NodeColumn") {
+  // a large payload that traversals of the CompactGraph never touch
+  struct Payload {
+    int id;
+    double energy;
+    char detail[240];
+  };
+  typedef DAG::Node<Payload> PNode;
+  std::vector<PNode> nodes;
+  for (int i = 0; i < 9; ++i)
+    nodes.emplace_back(Payload{i, 0.5 * i, {}});
+  linkExample(nodes);
+  auto all = pointers(nodes);
+
+  DAG::CompactGraph<PNode> graph(all);
+  DAG::NodeColumn<double> energy(graph, [](const PNode* node) { return node->value().energy; });
+  REQUIRE(energy.size() == 9);
+  REQUIRE(energy[graph.index(&nodes[7])] == 3.5);
+
+  // descendants of 1 (1 4 5 6): only the topology and the energy column are read
+  DAG::CompactBFS<PNode> bfs(graph);
+  double sum = 0;
+  for (auto i : bfs.traverse(graph.index(&nodes[1]), DAG::VisitType::CHILDREN))
+    sum += energy[i];
+  REQUIRE(sum == 0.5 * (1 + 4 + 5 + 6));
+}
+
+TEST_CASE("VariantNode") {
+  struct Track {
+    double pt;
+  };
+  struct Cluster {
+    double energy;
+  };
+  typedef DAG::VariantNode<Track, Cluster> VNode;
+  typedef VNode::value_type Payload;
+  VNode track(Track{2.5}), cluster1(Cluster{1.}), cluster2(Cluster{3.});
+  track.addChild(cluster1);
+  track.addChild(cluster2);
+
+  REQUIRE((DAG::tagOf<Track, Payload>() == 0));
+  REQUIRE((DAG::tagOf<Cluster, Payload>() == 1));
+  REQUIRE((DAG::tagOf<int, Payload>() == 2));  // not one of the types
+  REQUIRE(DAG::typeTag(cluster1) == 1);
+  REQUIRE(DAG::payloadIf<Track>(track)->pt == 2.5);
+  REQUIRE(DAG::payloadIf<Cluster>(track) == nullptr);
+
+  DAG::BFSVisitor<VNode> bfs;
+  double energy = 0;
+  int tracks = 0;
+  for (auto node : bfs.traverseChildren(track))
+    DAG::visitPayload(*node, DAG::Overloaded{[&](const Track&) { ++tracks; },
+                                             [&](const Cluster& cluster) { energy += cluster.energy; }});
+  REQUIRE(tracks == 1);
+  REQUIRE(energy == 4.);
+}
+
+TEST_CASE("TagMask") {
+  struct Track {};
+  struct Cluster {};
+  struct Particle {};
+  typedef DAG::VariantNode<Track, Cluster, Particle> VNode;
+  typedef VNode::value_type Payload;
+  // track 0 -> clusters 1 2, track 0 -> particle 3 -> cluster 4, particle 3 -> track 5
+  std::vector<VNode> nodes{VNode(Track()),    VNode(Cluster()), VNode(Cluster()),
+                           VNode(Particle()), VNode(Cluster()), VNode(Track())};
+  std::vector<std::pair<int, int>> links{{0, 1}, {0, 2}, {0, 3}, {3, 4}, {3, 5}};
+  for (auto& link : links)
+    nodes[link.first].addChild(nodes[link.second]);
+  auto all = pointers(nodes);
+
+  DAG::CompactGraph<VNode> graph(all);
+  REQUIRE(graph.tag(4) == 0);  // untagged
+  graph.setTags([](const VNode* node) { return DAG::typeTag(*node); });
+  REQUIRE(graph.tag(3) == 2);
+  REQUIRE(graph.hasTag(4, DAG::TagMask{1}));
+
+  const unsigned track = DAG::tagOf<Track, Payload>();
+  const unsigned cluster = DAG::tagOf<Cluster, Payload>();
+  DAG::CompactBFS<VNode> bfs(graph);
+  // only clusters below track 0: 0 1 2
+  REQUIRE(bfs.traverse(0, DAG::VisitType::CHILDREN, -1, DAG::TagMask{cluster}).size() == 3);
+  REQUIRE(!bfs.visited(4));
+  // tracks and clusters: the particle 3 is not entered, so neither 4 nor 5 are reached
+  REQUIRE(bfs.traverse(0, DAG::VisitType::CHILDREN, -1, DAG::TagMask{track, cluster}).size() == 3);
+  REQUIRE(bfs.traverse(0, DAG::VisitType::CHILDREN, -1, DAG::TagMask::all()).size() == 6);
+  // from cluster 4 upwards through particles only: 4 3
+  REQUIRE(bfs.traverse(4, DAG::VisitType::PARENTS, -1, DAG::TagMask().add(2)).size() == 2);
+  REQUIRE(bfs.levelOffsets() == std::vector<std::size_t>({0, 1, 2}));
+  REQUIRE(DAG::TagMask{63}.contains(63));
+  REQUIRE(!DAG::TagMask::all().contains(64));  // no such tag (and no shift by 64)
+}
+
+TEST_CASE("LayeredGraph") {
+  typedef DAG::Node<int> INode;
+  std::vector<INode> nodes;
+  for (int i = 0; i < 6; ++i)
+    nodes.emplace_back(i);
+  // history links are the links of the nodes: 0 -> 1, 0 -> 2, 3 -> 4
+  nodes[0].addChild(nodes[1]);
+  nodes[0].addChild(nodes[2]);
+  nodes[3].addChild(nodes[4]);
+  auto all = pointers(nodes);
+  DAG::LayeredGraph<INode> graph(all, "history");
+  // reconstruction links 1 -> 3 and 2 -> 5 (and one to a node outside the graph, which is dropped)
+  INode outside(9);
+  std::vector<std::pair<const INode*, const INode*>> reco{{&nodes[1], &nodes[3]}, {&nodes[2], &nodes[5]},
+                                                          {&nodes[2], &outside}};
+  REQUIRE(graph.addLayer("reco", reco) == 1);
+  REQUIRE(graph.layers() == 2);
+  REQUIRE(graph.layer("reco") == 1);
+  REQUIRE(graph.layer("other") == DAG::LayeredGraph<INode>::npos);
+  REQUIRE(graph.edges(0) == 3);
+  REQUIRE(graph.edges(1) == 2);
+  REQUIRE(graph.children(1, 1).size() == 1);
+  REQUIRE(graph.parents(5, 1)[0] == 2);
+  REQUIRE(graph.children(1).empty());  // layer 0
+  REQUIRE(graph.graph().edges() == 3);  // the CompactGraph of layer 0
+
+  DAG::CompactBFS<INode> bfs(graph);
+  REQUIRE(bfs.traverse(0, DAG::VisitType::CHILDREN).size() == 6);
+  bfs.setLayers(graph.select({"history"}));
+  REQUIRE(bfs.traverse(0, DAG::VisitType::CHILDREN).size() == 3);
+  bfs.setLayers(graph.select({"history", "reco"}));
+  int recoLinks = 0;
+  bfs.traverse(0, DAG::VisitType::CHILDREN, -1, [&recoLinks](unsigned, const DAG::CompactLink& link) {
+    recoLinks += link.layer == 1;
+    return true;
+  });
+  REQUIRE(recoLinks == 2);
+  DAG::CompactBFS<INode> recoBFS(graph, graph.select({"reco"}));
+  REQUIRE(recoBFS.traverse(5, DAG::VisitType::UNDIRECTED).size() == 2);
+
+  DAG::FloodFill<int> ffill;
+  REQUIRE(ffill.traverse(graph).size() == 1);
+  REQUIRE(ffill.traverse(graph, graph.select({"history"})).size() == 3);  // {0 1 2} {3 4} {5}
+  REQUIRE(ffill.traverse(graph, graph.select({"reco"})).size() == 4);     // {0} {1 3} {2 5} {4}
+  DAG::GraphBFS<DAG::LayeredGraph<INode>> history(graph);  // GraphTraits read layer 0
+  REQUIRE(history.traverse(0, DAG::VisitType::CHILDREN).size() == 3);
+}
+
+// relations kept the way an event store keeps them, searched in place through GraphTraits
+struct ParticleRelations {
+  std::vector<std::vector<int>> daughters;
+  std::vector<std::vector<int>> mothers;
+};
+namespace DAG {
+template <>
+struct GraphTraits<ParticleRelations> {
+  typedef int Handle;
+  static std::size_t size(const ParticleRelations& r) { return r.daughters.size(); }
+  static std::size_t index(const ParticleRelations&, int particle) { return particle; }
+  static int handle(const ParticleRelations&, std::size_t i) { return i; }
+  static const std::vector<int>& children(const ParticleRelations& r, int p) { return r.daughters[p]; }
+  static const std::vector<int>& parents(const ParticleRelations& r, int p) { return r.mothers[p]; }
+};
+}
+
+TEST_CASE("GraphTraits") {
+  // same graph as the DAG test
+  ParticleRelations relations;
+  relations.daughters.resize(9);
+  relations.mothers.resize(9);
+  for (auto& link : exampleLinks) {
+    relations.daughters[link.first].push_back(link.second);
+    relations.mothers[link.second].push_back(link.first);
+  }
+
+  DAG::GraphBFS<ParticleRelations> bfs(relations);
+  REQUIRE(bfs.traverse(0, DAG::VisitType::CHILDREN) == std::vector<int>({0, 1, 2, 3, 4, 5, 6}));
+  REQUIRE(bfs.levelOffsets() == std::vector<std::size_t>({0, 1, 4, 7}));
+  REQUIRE(bfs.traverse(6, DAG::VisitType::PARENTS, 1).size() == 3);
+  REQUIRE(bfs.traverse(8, DAG::VisitType::UNDIRECTED).size() == 9);
+  REQUIRE(bfs.traverse(std::vector<int>{2, 8}, DAG::VisitType::CHILDREN).size() == 2);
+  REQUIRE(bfs.visited(8));
+  REQUIRE(!bfs.visited(4));
+
+  DAG::GraphFloodFill<ParticleRelations> ffill;
+  relations.daughters[7].clear();  // 7 and 8 become blocks of their own
+  relations.mothers[8].clear();
+  relations.mothers[4] = {1};
+  auto blocks = ffill.traverse(relations);
+  REQUIRE(blocks.size() == 3);
+  REQUIRE(blocks[0].size() == 7);
+
+  // the same algorithms on a CompactGraph
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();
+  DAG::CompactGraph<INode> graph(pointers(nodes));
+  DAG::GraphBFS<DAG::CompactGraph<INode>> compactBFS(graph);
+  REQUIRE(compactBFS.traverse(4, DAG::VisitType::PARENTS).size() == 4);  // 4 1 7 0
+  DAG::GraphFloodFill<DAG::CompactGraph<INode>> compactFill;
+  DAG::GraphFloodFill<DAG::CompactGraph<INode>>::Blocks flat;
+  compactFill.fill(graph, flat);
+  REQUIRE(flat.size() == 1);
+  REQUIRE(flat.block(0).size() == 9);
+
+  // and on the Nodes themselves
+  DAG::NodeGraph<INode> nodeGraph(pointers(nodes));
+  DAG::GraphBFS<DAG::NodeGraph<INode>> nodeBFS(nodeGraph);
+  REQUIRE(nodeBFS.traverse(&nodes[4], DAG::VisitType::PARENTS).size() == 4);
+  REQUIRE(nodeBFS.levelOffsets() == std::vector<std::size_t>({0, 1, 3, 4}));
+  nodes[7].removeChild(nodes[4]);
+  nodes[7].removeChild(nodes[8]);
+  DAG::GraphFloodFill<DAG::NodeGraph<INode>> nodeFill;
+  REQUIRE(nodeFill.traverse(nodeGraph).size() == 3);  // {0 .. 6} {7} {8}
+}
+
+TEST_CASE("Reordering") {
+  typedef DAG::Node<int> INode;
+  auto nodes = exampleGraph<INode>();  // same graph as the DAG test
+  // index the nodes in a shuffled order
+  std::vector<int> shuffled{5, 8, 0, 3, 7, 1, 6, 2, 4};
+  DAG::Nodevector<INode> all;
+  for (int i : shuffled)
+    all.push_back(&nodes[i]);
+
+  DAG::Reordering<INode> reordering;
+  for (auto ordering : {DAG::Ordering::BFS, DAG::Ordering::RCM, DAG::Ordering::HUBS}) {
+    DAG::CompactGraph<INode> graph(all, [](const INode* parent, const INode* child) {
+      return 10. * parent->value() + child->value();
+    });
+    graph.setTags([](const INode* node) { return node->value() % 2; });
+    DAG::NodeColumn<int> value(graph, [](const INode* node) { return node->value(); });
+    DAG::EdgeColumn<int> parentValue(graph, [](const INode* parent, const INode*) { return parent->value(); });
+    auto order = reordering.compute(graph, ordering);
+    std::vector<unsigned> sorted(order);
+    std::sort(sorted.begin(), sorted.end());
+    REQUIRE(sorted == std::vector<unsigned>({0, 1, 2, 3, 4, 5, 6, 7, 8}));  // a permutation
+    REQUIRE(reordering.newIndex()[order[3]] == 3);
+    unsigned before = graph.index(&nodes[7]);
+    std::vector<unsigned> childSlots, parentSlots;
+    graph.permute(order, childSlots, parentSlots);
+    value.permute(order);
+    parentValue.permute(childSlots, parentSlots);
+    REQUIRE(graph.index(&nodes[7]) == reordering.newIndex()[before]);
+    // the links, weights, tags and column values follow their nodes
+    for (unsigned i = 0; i < graph.size(); ++i) {
+      REQUIRE(graph.node(i)->value() == value[i]);
+      REQUIRE(graph.tag(i) == value[i] % 2);
+      REQUIRE(graph.children(i).size() == graph.node(i)->children().size());
+      for (unsigned j = 0; j < graph.children(i).size(); ++j) {
+        unsigned child = graph.children(i)[j];
+        REQUIRE(graph.node(i)->children().count(graph.node(child)) == 1);
+        REQUIRE(graph.childWeights(i)[j] == 10. * value[i] + value[child]);
+        REQUIRE(parentValue.child(graph.childOffsets()[i] + j) == value[i]);
+      }
+      for (unsigned j = 0; j < graph.parents(i).size(); ++j) {
+        REQUIRE(graph.parentWeights(i)[j] == 10. * value[graph.parents(i)[j]] + value[i]);
+        REQUIRE(parentValue.parent(graph.parentOffsets()[i] + j) == value[graph.parents(i)[j]]);
+      }
+    }
+    DAG::CompactBFS<INode> bfs(graph);
+    REQUIRE(bfs.traverse(graph.index(&nodes[1]), DAG::VisitType::CHILDREN).size() == 4);
+  }
+
+  // BFS order numbers the nodes by distance from the first node: 4, then 1, then 0, then 2 and 3
+  DAG::CompactGraph<INode> graph(DAG::Nodevector<INode>({&nodes[4], &nodes[2], &nodes[0], &nodes[1], &nodes[3]}));
+  auto order = reordering.compute(graph, DAG::Ordering::BFS);
+  REQUIRE(order.size() == 5);
+  REQUIRE(graph.node(order[0])->value() == 4);
+  REQUIRE(graph.node(order[1])->value() == 1);
+  REQUIRE(graph.node(order[2])->value() == 0);
+  REQUIRE(reordering.compute(graph, DAG::Ordering::HUBS).front() == 2);  // node 0 has the largest degree
+  // RCM starts from a node of degree 1 and ends with it
+  order = reordering.compute(graph, DAG::Ordering::RCM);
+  REQUIRE(graph.node(order.back())->value() == 4);
+
+  // the extra layers of a LayeredGraph follow too
+  DAG::LayeredGraph<INode> layered(all);
+  std::vector<std::pair<const INode*, const INode*>> extra{{&nodes[2], &nodes[8]}};
+  layered.addLayer("extra", extra);
+  layered.permute(reordering.compute(layered.graph(), DAG::Ordering::RCM));
+  REQUIRE(layered.node(layered.children(layered.index(&nodes[2]), 1)[0]) == &nodes[8]);
+}
+
+TEST_CASE("Prefetch") {
+  // prefetching must not change what is found, or in which order
+  typedef DAG::Node<int> INode;
+  std::mt19937 random(3);
+  std::vector<INode> nodes;
+  for (int i = 0; i < 2000; ++i)
+    nodes.emplace_back(i);
+  for (int i = 1; i < 2000; ++i)
+    nodes[random() % i].addChild(nodes[i]);
+  for (int i = 0; i < 500; ++i) {
+    int a = random() % 2000, b = random() % 2000;
+    if (a < b) nodes[a].addChild(nodes[b]);
+  }
+  auto all = pointers(nodes);
+  DAG::CompactGraph<INode> graph(all);
+
+  DAG::BFSVisitor<INode> plain, prefetching;
+  DAG::BFSLevelVisitor<INode> levelPlain, levelPrefetching;
+  DAG::BFSTreeVisitor<INode> treePlain, treePrefetching;
+  DAG::CompactBFS<INode> compactPlain(graph), compactPrefetching(graph);
+  for (unsigned distance : {1, 2, 8, 64}) {
+    prefetching.setPrefetchDistance(distance);
+    levelPrefetching.setPrefetchDistance(distance);
+    treePrefetching.setPrefetchDistance(distance);
+    compactPrefetching.setPrefetchDistance(distance);
+    REQUIRE(prefetching.prefetchDistance() == distance);
+    for (int start : {0, 17, 1999}) {
+      REQUIRE(prefetching.traverseUndirected(nodes[start]) == plain.traverseUndirected(nodes[start]));
+      REQUIRE(prefetching.traverseChildren(nodes[start], 3) == plain.traverseChildren(nodes[start], 3));
+      REQUIRE(prefetching.traverseParents(nodes[start]) == plain.traverseParents(nodes[start]));
+      REQUIRE(levelPrefetching.traverseUndirected(nodes[start]) == levelPlain.traverseUndirected(nodes[start]));
+      REQUIRE(levelPrefetching.levelOffsets() == levelPlain.levelOffsets());
+      REQUIRE(treePrefetching.traverseChildren(nodes[start], 3) == treePlain.traverseChildren(nodes[start], 3));
+      REQUIRE(treePrefetching.predecessors() == treePlain.predecessors());
+      for (auto visittype : {DAG::VisitType::CHILDREN, DAG::VisitType::PARENTS, DAG::VisitType::UNDIRECTED}) {
+        auto expected = compactPlain.traverse(start, visittype);
+        REQUIRE(compactPrefetching.traverse(start, visittype) == expected);
+        REQUIRE(compactPrefetching.levelOffsets() == compactPlain.levelOffsets());
+      }
+    }
+  }
+}